@@ -0,0 +1,87 @@
+// Copyright 2019 Nedelcu Horia (nedelcu.horia.alexandru@gmail.com)
+
+/**
+ * hash_bench.cpp
+ *
+ * Lookups per second of Hashtable and FlatMap on intersection-like names.
+ * Usage: hash_bench [nr_keys] [nr_lookups]
+ */
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include "../hashtable.h"
+#include "../flat_map.h"
+#include "../hash_functions.h"
+
+// Return names like the ones of the map inputs, e.g. "Strada_1234"
+std::vector<std::string> make_names(int count, const char *prefix) {
+    std::vector<std::string> names(count);
+
+    for (int i = 0; i < count; ++i) {
+        names[i] = prefix + std::to_string(i);
+    }
+
+    return names;
+}
+
+/**
+ * Fills a map with keys, then times lookups of the queries.
+ *
+ * @return lookups per second.
+ */
+template <typename Tmap>
+double bench_lookups(const std::vector<std::string>& keys,
+                     const std::vector<std::string>& queries,
+                     long long *checksum) {
+    Tmap map(HASH_INITIAL_CAPACITY, string_hash);
+    std::chrono::duration<double> elapsed;
+    long long sum = 0;
+
+    for (unsigned int i = 0; i < keys.size(); ++i) {
+        map.set(keys[i], i);
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (unsigned int i = 0; i < queries.size(); ++i) {
+        sum += map.lookup(queries[i])? map[queries[i]]: -1;
+    }
+    elapsed = std::chrono::high_resolution_clock::now() - start;
+
+    *checksum = sum;
+    return queries.size() / elapsed.count();
+}
+
+int main(int argc, char **argv) {
+    int nr_keys = (argc > 1)? std::atoi(argv[1]): 100000;
+    int nr_lookups = (argc > 2)? std::atoi(argv[2]): 2000000;
+    std::vector<std::string> keys = make_names(nr_keys, "Strada_");
+    std::vector<std::string> misses = make_names(nr_keys, "Bulevardul_");
+    std::vector<std::string> queries(nr_lookups);
+    std::mt19937 rng(2019);
+    long long sum_table, sum_flat;
+
+    // three hits for every miss
+    for (int i = 0; i < nr_lookups; ++i) {
+        queries[i] = (rng() % 4)? keys[rng() % nr_keys]:
+                                   misses[rng() % nr_keys];
+    }
+
+    double table = bench_lookups<Hashtable<std::string, int>>(keys, queries,
+                                                              &sum_table);
+    double flat = bench_lookups<FlatMap<std::string, int>>(keys, queries,
+                                                           &sum_flat);
+
+    if (sum_table != sum_flat) {
+        std::printf("maps disagree\n");
+        return 1;
+    }
+
+    std::printf("keys %d, lookups %d\n", nr_keys, nr_lookups);
+    std::printf("Hashtable %12.0f lookups/s\n", table);
+    std::printf("FlatMap   %12.0f lookups/s (%.2fx)\n", flat, flat / table);
+    return 0;
+}
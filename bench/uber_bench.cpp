@@ -0,0 +1,201 @@
+// Copyright 2019 Nedelcu Horia (nedelcu.horia.alexandru@gmail.com)
+
+/**
+ * uber_bench.cpp
+ *
+ * End-to-end benchmark of the solver on generated cities. Every point of
+ * the sweep (shape x nodes x extra roads x drivers x queries) is run reps
+ * times through tasks 1 to 5, and the report is printed as JSON.
+ *
+ * Usage: uber_bench [--shapes grid,ring-radial,scale-free]
+ *                   [--nodes 1000,4000] [--extra 0,0.5]
+ *                   [--drivers 50,500] [--queries 10000]
+ *                   [--reps 5] [--seed 2019]
+ */
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "../solver.h"
+#include "./workload.h"
+
+#define BENCH_INPUT "uber_bench.in"
+
+// Return the comma separated values of an option
+template <typename T>
+std::vector<T> parse_list(const char *text, T (*parse)(const char *)) {
+    std::vector<T> values;
+    std::string item;
+
+    for (const char *c = text; ; ++c) {
+        if (*c == ',' || *c == '\0') {
+            values.push_back(parse(item.c_str()));
+            item.clear();
+        } else {
+            item += *c;
+        }
+
+        if (*c == '\0') {
+            return values;
+        }
+    }
+}
+
+int parse_int(const char *text) {
+    return std::atoi(text);
+}
+
+double parse_double(const char *text) {
+    return std::atof(text);
+}
+
+CityShape parse_shape(const char *text) {
+    if (!std::strcmp(text, "grid")) {
+        return GRID;
+    }
+    if (!std::strcmp(text, "ring-radial")) {
+        return RING_RADIAL;
+    }
+    return SCALE_FREE;
+}
+
+// Return the value at the given percentile (nearest rank) of sorted times
+double percentile(const std::vector<double>& sorted, double p) {
+    int rank = (int)(p / 100.0 * sorted.size() + 0.999999);
+
+    return sorted[std::min(std::max(rank, 1), (int)sorted.size()) - 1];
+}
+
+/**
+ * Runs tasks 1 to 5 on the input file with a fresh solver.
+ *
+ * @param times Filled with the milliseconds each task took.
+ */
+void run_once(std::vector<double>& times) {
+    std::chrono::time_point<std::chrono::steady_clock> start;
+    std::chrono::duration<double, std::milli> elapsed;
+    InputReader fin(BENCH_INPUT);
+    OutputWriter fout("/dev/null");
+    solver s;
+
+    for (int task = 1; task <= 5; ++task) {
+        start = std::chrono::steady_clock::now();
+        switch (task) {
+            case 1:
+                s.task1_solver(fin, fout);
+                break;
+            case 2:
+                s.task2_solver(fin, fout);
+                break;
+            case 3:
+                s.task3_solver(fin, fout);
+                break;
+            case 4:
+                s.task4_solver(fin, fout);
+                break;
+            default:
+                s.task5_solver(fin, fout);
+        }
+        fout.flush();
+        elapsed = std::chrono::steady_clock::now() - start;
+        times[task - 1] = elapsed.count();
+    }
+}
+
+// Benchmarks one point of the sweep and prints its JSON object
+void bench_point(const WorkloadConfig& config, int reps, bool first) {
+    Workload workload(config);
+    std::vector<std::vector<double>> times(5, std::vector<double>(reps));
+    std::vector<double> once(5);
+    FILE *file = std::fopen(BENCH_INPUT, "w");
+
+    std::fwrite(workload.getText().data(), 1, workload.getText().size(),
+                file);
+    std::fclose(file);
+
+    for (int r = 0; r < reps; ++r) {
+        run_once(once);
+        for (int t = 0; t < 5; ++t) {
+            times[t][r] = once[t];
+        }
+    }
+
+    std::printf("%s    {\"shape\": \"%s\", \"nodes\": %d, \"roads\": %d, "
+                "\"drivers\": %d, \"queries\": %d, \"reps\": %d, "
+                "\"tasks\": [\n", first? "": ",\n", shape_name(config.shape),
+                workload.getNodes(), workload.getRoads(), config.drivers,
+                config.queries, reps);
+
+    for (int t = 0; t < 5; ++t) {
+        std::sort(times[t].begin(), times[t].end());
+
+        // task1 loads the map, task5 is a single query
+        double ops = (t == 0)? config.queries + workload.getRoads():
+                     (t == 3)? config.queries + config.drivers:
+                     (t == 4)? 1: config.queries;
+        double median = percentile(times[t], 50);
+
+        std::printf("      {\"task\": %d, \"median_ms\": %.3f, "
+                    "\"p99_ms\": %.3f, \"ops_per_sec\": %.0f}%s\n", t + 1,
+                    median, percentile(times[t], 99),
+                    median > 0? ops / (median / 1000): 0.0,
+                    t < 4? ",": "");
+    }
+    std::printf("    ]}");
+    std::fflush(stdout);
+}
+
+int main(int argc, char **argv) {
+    std::vector<CityShape> shapes = {GRID, RING_RADIAL, SCALE_FREE};
+    std::vector<int> nodes = {1000, 4000}, drivers = {50, 500};
+    std::vector<int> queries = {10000};
+    std::vector<double> extra = {0, 0.5};
+    int reps = 5;
+    unsigned int seed = 2019;
+    bool first = true;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!std::strcmp(argv[i], "--shapes")) {
+            shapes = parse_list(argv[i + 1], parse_shape);
+        } else if (!std::strcmp(argv[i], "--nodes")) {
+            nodes = parse_list(argv[i + 1], parse_int);
+        } else if (!std::strcmp(argv[i], "--extra")) {
+            extra = parse_list(argv[i + 1], parse_double);
+        } else if (!std::strcmp(argv[i], "--drivers")) {
+            drivers = parse_list(argv[i + 1], parse_int);
+        } else if (!std::strcmp(argv[i], "--queries")) {
+            queries = parse_list(argv[i + 1], parse_int);
+        } else if (!std::strcmp(argv[i], "--reps")) {
+            reps = std::max(1, std::atoi(argv[i + 1]));
+        } else if (!std::strcmp(argv[i], "--seed")) {
+            seed = std::atoi(argv[i + 1]);
+        } else {
+            std::fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    std::printf("{\"runs\": [\n");
+    for (auto shape : shapes) {
+        for (int n : nodes) {
+            for (double e : extra) {
+                for (int d : drivers) {
+                    for (int q : queries) {
+                        WorkloadConfig config = {shape, n, e, d, q, seed};
+
+                        bench_point(config, reps, first);
+                        first = false;
+                    }
+                }
+            }
+        }
+    }
+    std::printf("\n]}\n");
+
+    std::remove(BENCH_INPUT);
+    return 0;
+}
@@ -0,0 +1,219 @@
+// Copyright 2019 Nedelcu Horia (nedelcu.horia.alexandru@gmail.com)
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <utility>
+#include <vector>
+#include "./workload.h"
+
+Workload::Workload(const WorkloadConfig& config): config_(config),
+    rng_(config.seed), names_(), roads_(), text_() {
+    switch (config_.shape) {
+        case GRID:
+            buildGrid();
+            break;
+        case RING_RADIAL:
+            buildRingRadial();
+            break;
+        default:
+            buildScaleFree();
+    }
+
+    // random shortcuts on top of the shape
+    int extra = config_.extra * names_.size();
+    for (int i = 0; i < extra; ++i) {
+        roads_.push_back(std::make_pair(node(), node()));
+    }
+
+    appendMap();
+    appendPairs(config_.queries);  // task1
+    appendPairs(config_.queries);  // task2
+    appendTask3();
+    appendTask4();
+    appendTask5();
+}
+
+Workload::~Workload() {}
+
+inline int Workload::node() {
+    return rng_() % names_.size();
+}
+
+void Workload::addStreet(int src, int dst) {
+    roads_.push_back(std::make_pair(src, dst));
+
+    if (rng_() % 5) {
+        roads_.push_back(std::make_pair(dst, src));
+    }
+}
+
+void Workload::buildGrid() {
+    int width = std::max(1, (int)std::sqrt((double)config_.nodes));
+
+    for (int i = 0; i < width * width; ++i) {
+        names_.push_back("Strada_" + std::to_string(i));
+    }
+
+    for (int i = 0; i < width; ++i) {
+        for (int j = 0; j < width; ++j) {
+            if (j + 1 < width) {
+                addStreet(i * width + j, i * width + j + 1);
+            }
+            if (i + 1 < width) {
+                addStreet(i * width + j, (i + 1) * width + j);
+            }
+        }
+    }
+}
+
+void Workload::buildRingRadial() {
+    // a center, then rings of spokes intersections around it
+    int spokes = std::max(4, (int)std::sqrt((double)config_.nodes));
+    int rings = std::max(1, (config_.nodes - 1) / spokes);
+
+    names_.push_back("Piata_Centrala");
+    for (int r = 0; r < rings; ++r) {
+        for (int s = 0; s < spokes; ++s) {
+            names_.push_back("Inel_" + std::to_string(r) + "_" +
+                             std::to_string(s));
+
+            int here = 1 + r * spokes + s;
+            addStreet(here, 1 + r * spokes + (s + 1) % spokes);
+            addStreet(r? here - spokes: 0, here);
+        }
+    }
+}
+
+void Workload::buildScaleFree() {
+    // preferential attachment: a new intersection links to two old ones,
+    // picked in proportion to their number of roads
+    std::vector<int> ends;
+
+    for (int i = 0; i < std::max(config_.nodes, 2); ++i) {
+        names_.push_back("Bulevard_" + std::to_string(i));
+
+        if (i == 0) {
+            continue;
+        }
+
+        for (int k = 0; k < 2; ++k) {
+            int other = ends.empty()? 0: ends[rng_() % ends.size()];
+
+            if (other == i) {
+                continue;
+            }
+
+            addStreet(i, other);
+            ends.push_back(i);
+            ends.push_back(other);
+        }
+    }
+}
+
+void Workload::appendPairs(int count) {
+    text_ += std::to_string(count) + '\n';
+
+    for (int i = 0; i < count; ++i) {
+        text_ += names_[node()] + ' ' + names_[node()] + '\n';
+    }
+}
+
+void Workload::appendMap() {
+    text_ += std::to_string(names_.size()) + ' ' +
+             std::to_string(roads_.size()) + '\n';
+
+    for (auto it = names_.begin(); it != names_.end(); ++it) {
+        text_ += *it + '\n';
+    }
+
+    for (auto it = roads_.begin(); it != roads_.end(); ++it) {
+        text_ += names_[it->first] + ' ' + names_[it->second] + '\n';
+    }
+}
+
+void Workload::appendTask3() {
+    text_ += std::to_string(config_.queries) + '\n';
+
+    // one road change in ten, the rest are the three query types
+    for (int i = 0; i < config_.queries; ++i) {
+        int type = rng_() % 4;
+
+        if (rng_() % 10 == 0) {
+            text_ += "c " + names_[node()] + ' ' + names_[node()] + ' ' +
+                     std::to_string(type) + '\n';
+        } else if (type % 3 == 2) {
+            text_ += "q " + names_[node()] + ' ' + names_[node()] + " 2 " +
+                     names_[node()] + '\n';
+        } else {
+            text_ += "q " + names_[node()] + ' ' + names_[node()] + ' ' +
+                     std::to_string(type % 3) + '\n';
+        }
+    }
+}
+
+void Workload::appendTask4() {
+    static const char *ratings[] = {"5", "4.5", "4", "3.5", "2", "1"};
+    int drivers = std::max(1, config_.drivers);
+
+    // every driver comes online first, then the mixed events
+    text_ += std::to_string(drivers + config_.queries) + '\n';
+    for (int i = 0; i < drivers; ++i) {
+        text_ += "d Sofer_" + std::to_string(i) + ' ' + names_[node()] + '\n';
+    }
+
+    for (int i = 0; i < config_.queries; ++i) {
+        int kind = rng_() % 20;
+        std::string driver = "Sofer_" + std::to_string(rng_() % drivers);
+
+        if (kind < 10) {
+            text_ += "r " + names_[node()] + ' ' + names_[node()] + ' ' +
+                     ratings[rng_() % 6] + '\n';
+        } else if (kind < 12) {
+            text_ += "b " + driver + '\n';
+        } else if (kind < 14) {
+            text_ += "d " + driver + ' ' + names_[node()] + '\n';
+        } else if (kind < 15) {
+            text_ += "top_rating 10\n";
+        } else if (kind < 16) {
+            text_ += "top_dist 10\n";
+        } else if (kind < 17) {
+            text_ += "top_rides 10\n";
+        } else {
+            text_ += "info " + driver + '\n';
+        }
+    }
+}
+
+void Workload::appendTask5() {
+    int candidates = std::min((int)names_.size(), 1000);
+
+    text_ += std::to_string(rng_() % 50 + 1) + " Sofer_0\n" +
+             std::to_string(candidates) + '\n';
+    for (int i = 0; i < candidates; ++i) {
+        text_ += names_[node()] + '\n';
+    }
+}
+
+const std::string& Workload::getText() const {
+    return text_;
+}
+
+int Workload::getNodes() const {
+    return names_.size();
+}
+
+int Workload::getRoads() const {
+    return roads_.size();
+}
+
+const char *shape_name(CityShape shape) {
+    switch (shape) {
+        case GRID:
+            return "grid";
+        case RING_RADIAL:
+            return "ring-radial";
+        default:
+            return "scale-free";
+    }
+}
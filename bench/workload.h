@@ -0,0 +1,78 @@
+// Copyright 2019 Nedelcu Horia (nedelcu.horia.alexandru@gmail.com)
+
+/**
+ * workload.h
+ */
+
+#ifndef BENCH_WORKLOAD_H_
+#define BENCH_WORKLOAD_H_
+
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Shape of a generated city
+enum CityShape {GRID, RING_RADIAL, SCALE_FREE};
+
+// Parameters of one generated input
+struct WorkloadConfig {
+    CityShape shape;
+    int nodes;         // intersections, rounded to fit the shape
+    double extra;      // random extra roads, per intersection
+    int drivers;
+    int queries;       // queries of each task
+    unsigned int seed;
+};
+
+/**
+ * Seeded generator of inputs in the homework format: a city graph of the
+ * given shape, then the query mix of every task.
+ */
+class Workload {
+ private:
+    WorkloadConfig config_;
+    std::mt19937 rng_;
+    std::vector<std::string> names_;
+    std::vector<std::pair<int, int>> roads_;
+    std::string text_;
+
+    // Return a random intersection
+    inline int node();
+
+    // Adds a road, and the one back unless it is one way (20% of them)
+    void addStreet(int src, int dst);
+
+    // Builds the roads of each shape
+    void buildGrid();
+    void buildRingRadial();
+    void buildScaleFree();
+
+    // Appends "name name" pairs of random intersections
+    void appendPairs(int count);
+
+    // Appends the input of each task
+    void appendMap();
+    void appendTask3();
+    void appendTask4();
+    void appendTask5();
+
+ public:
+    // Constructor; generates the whole input
+    explicit Workload(const WorkloadConfig& config);
+
+    // Destructor
+    ~Workload();
+
+    // Return the input text
+    const std::string& getText() const;
+
+    // Return number of intersections and roads generated
+    int getNodes() const;
+    int getRoads() const;
+};
+
+// Return the name of a shape, as used in the JSON report
+const char *shape_name(CityShape shape);
+
+#endif  // BENCH_WORKLOAD_H_
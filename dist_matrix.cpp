@@ -0,0 +1,110 @@
+// Copyright 2019 Nedelcu Horia (nedelcu.horia.alexandru@gmail.com)
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "./dist_matrix.h"
+
+int DistMatrix::widthFor(int max_dist) {
+    if (max_dist < UINT8_MAX) {
+        return 1;
+    } else if (max_dist < UINT16_MAX) {
+        return 2;
+    }
+
+    return 4;
+}
+
+DistMatrix::DistMatrix(): size_(0), width_(1), data_(), transposed_(),
+    rows_(nullptr) {}
+
+DistMatrix::~DistMatrix() {}
+
+void DistMatrix::reset(int size, int max_dist) {
+    size_ = size;
+    width_ = widthFor(max_dist);
+
+    // all-ones bytes are the "unreachable" sentinel for every width
+    data_.assign((size_t)size_ * size_ * width_, UINT8_MAX);
+    data_.shrink_to_fit();
+    rows_ = data_.data();
+    transposed_.clear();
+    transposed_.shrink_to_fit();
+}
+
+void DistMatrix::attach(const uint8_t *data, int size, int width) {
+    size_ = size;
+    width_ = width;
+    rows_ = data;
+
+    data_.clear();
+    data_.shrink_to_fit();
+    dropTransposed();
+}
+
+void DistMatrix::narrow(int max_dist) {
+    int width = widthFor(max_dist);
+    size_t i, count = (size_t)size_ * size_;
+
+    dropTransposed();
+
+    if (width >= width_) {
+        return;
+    }
+
+    // element i moves from i * width_ to i * width, which never overwrites
+    // an element not yet moved
+    for (i = 0; i < count; ++i) {
+        int dist = load(data_.data(), i);
+        uint16_t u16 = (dist == -1)? UINT16_MAX: dist;
+
+        if (width == 1) {
+            data_[i] = (dist == -1)? UINT8_MAX: dist;
+        } else {
+            memcpy(&data_[i * 2], &u16, sizeof(u16));
+        }
+    }
+
+    width_ = width;
+    data_.resize(count * width_);
+    data_.shrink_to_fit();
+    rows_ = data_.data();
+}
+
+void DistMatrix::buildTransposed() {
+    int row, col;
+
+    transposed_.resize((size_t)size_ * size_ * width_);
+
+    for (row = 0; row < size_; ++row) {
+        for (col = 0; col < size_; ++col) {
+            memcpy(&transposed_[((size_t)col * size_ + row) * width_],
+                   &rows_[((size_t)row * size_ + col) * width_], width_);
+        }
+    }
+}
+
+void DistMatrix::dropTransposed() {
+    transposed_.clear();
+    transposed_.shrink_to_fit();
+}
+
+bool DistMatrix::hasTransposed() const {
+    return !transposed_.empty();
+}
+
+int DistMatrix::getSize() const {
+    return size_;
+}
+
+int DistMatrix::getWidth() const {
+    return width_;
+}
+
+const uint8_t *DistMatrix::getData() const {
+    return rows_;
+}
+
+size_t DistMatrix::getBytes() const {
+    return data_.size() + transposed_.size();
+}
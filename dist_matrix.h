@@ -0,0 +1,163 @@
+// Copyright 2019 Nedelcu Horia (nedelcu.horia.alexandru@gmail.com)
+
+/**
+ * dist_matrix.h
+ */
+
+#ifndef DIST_MATRIX_H_
+#define DIST_MATRIX_H_
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/**
+ * Square matrix of BFS distances kept in one contiguous block. Elements are
+ * 1, 2 or 4 bytes wide; the all-ones value of each width (0xFF, 0xFFFF, -1)
+ * is reserved for "unreachable" and reads back as -1.
+ */
+class DistMatrix {
+ private:
+    int size_;
+    int width_;
+    std::vector<uint8_t> data_;        // row-major
+    std::vector<uint8_t> transposed_;  // column-major, empty if not built
+    const uint8_t *rows_;              // data_, or rows attached read-only
+
+    // Reads the element at the given index of a block of the current width
+    inline int load(const uint8_t *block, size_t index) const;
+
+ public:
+    // Constructor
+    DistMatrix();
+
+    // Destructor
+    ~DistMatrix();
+
+    // Return the narrowest element width whose sentinel is above max_dist,
+    // the width reset() and narrow() pick
+    static int widthFor(int max_dist);
+
+    /**
+     * Resizes to size x size, all unreachable. Elements are made wide enough
+     * for any distance up to max_dist; see narrow().
+     *
+     * @param size Number of nodes.
+     * @param max_dist Bound on the distances, such as distBound() of the
+     * graph (reach_index.h).
+     */
+    void reset(int size, int max_dist);
+
+    /**
+     * Reads the rows from memory the matrix does not own, such as a mapped
+     * snapshot, instead of copying them. The memory must outlive the
+     * matrix; set() must not be called until the next reset().
+     *
+     * @param data size x size elements, row-major, as getData() gives them.
+     * @param size Number of nodes.
+     * @param width Element width in bytes: 1, 2 or 4.
+     */
+    void attach(const uint8_t *data, int size, int width);
+
+    /**
+     * Sets a distance. Threads may set elements of different rows at once.
+     *
+     * @param row Source node.
+     * @param col Destination node.
+     * @param dist Distance from row to col, -1 if unreachable.
+     */
+    inline void set(int row, int col, int dist);
+
+    /**
+     * Gets a distance from the row-major block.
+     *
+     * @return distance from row to col, -1 if unreachable.
+     */
+    inline int get(int row, int col) const;
+
+    /**
+     * Gets the same distance as get(row, col), but reads the column-major
+     * copy when there is one. Use it when scanning many rows of one column.
+     *
+     * @return distance from row to col, -1 if unreachable.
+     */
+    inline int getByColumn(int row, int col) const;
+
+    /**
+     * Shrinks the elements to the narrowest width that holds every distance
+     * up to max_dist (the graph diameter). Drops the column-major copy.
+     *
+     * @param max_dist Largest distance stored in the matrix.
+     */
+    void narrow(int max_dist);
+
+    // Builds the column-major copy read by getByColumn
+    void buildTransposed();
+
+    // Frees the column-major copy
+    void dropTransposed();
+
+    // Return true if the column-major copy is built
+    bool hasTransposed() const;
+
+    // Return number of rows (and columns)
+    int getSize() const;
+
+    // Return element width in bytes
+    int getWidth() const;
+
+    // Return the row-major elements, getSize()^2 * getWidth() bytes
+    const uint8_t *getData() const;
+
+    // Return memory owned by the elements, both layouts
+    size_t getBytes() const;
+};
+
+inline int DistMatrix::load(const uint8_t *block, size_t index) const {
+    uint16_t u16;
+    int32_t i32;
+
+    switch (width_) {
+        case 1:
+            return (block[index] == UINT8_MAX)? -1: block[index];
+        case 2:
+            memcpy(&u16, &block[index * 2], sizeof(u16));
+            return (u16 == UINT16_MAX)? -1: u16;
+        default:
+            memcpy(&i32, &block[index * 4], sizeof(i32));
+            return i32;
+    }
+}
+
+inline void DistMatrix::set(int row, int col, int dist) {
+    size_t index = (size_t)row * size_ + col;
+    uint16_t u16;
+    int32_t i32;
+
+    switch (width_) {
+        case 1:
+            data_[index] = (dist == -1)? UINT8_MAX: dist;
+            break;
+        case 2:
+            u16 = (dist == -1)? UINT16_MAX: dist;
+            memcpy(&data_[index * 2], &u16, sizeof(u16));
+            break;
+        default:
+            i32 = dist;
+            memcpy(&data_[index * 4], &i32, sizeof(i32));
+    }
+}
+
+inline int DistMatrix::get(int row, int col) const {
+    return load(rows_, (size_t)row * size_ + col);
+}
+
+inline int DistMatrix::getByColumn(int row, int col) const {
+    if (transposed_.empty()) {
+        return load(rows_, (size_t)row * size_ + col);
+    }
+
+    return load(transposed_.data(), (size_t)col * size_ + row);
+}
+
+#endif  // DIST_MATRIX_H_
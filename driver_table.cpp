@@ -0,0 +1,327 @@
+// Copyright 2019 Nedelcu Horia (nedelcu.horia.alexandru@gmail.com)
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <string_view>
+#include <vector>
+#include "./driver_table.h"
+
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+// Return the name key nearest() picks, NAME_KEY_END if no driver is
+// reachable; d holds the distances, unreachable as the largest unsigned
+static uint64_t bestKey(const unsigned int *d, const double *score,
+                        const uint64_t *key, int count) {
+    unsigned int min_dist = std::numeric_limits<unsigned int>::max();
+    double max_score = -std::numeric_limits<double>::infinity();
+    uint64_t min_key = NAME_KEY_END;
+
+    for (int i = 0; i < count; ++i) {
+        min_dist = (d[i] < min_dist)? d[i]: min_dist;
+    }
+
+    if (min_dist == std::numeric_limits<unsigned int>::max()) {
+        return NAME_KEY_END;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        double s = (d[i] == min_dist)? score[i]:
+                   -std::numeric_limits<double>::infinity();
+        max_score = (s > max_score)? s: max_score;
+    }
+
+    // the first name among the closest, best rated drivers
+    for (int i = 0; i < count; ++i) {
+        uint64_t k = (d[i] == min_dist && score[i] == max_score)?
+                     key[i]: NAME_KEY_END;
+        min_key = (k < min_key)? k: min_key;
+    }
+
+    return min_key;
+}
+
+#ifdef __x86_64__
+// Same as bestKey, 8 distances or 4 scores and keys at a time
+__attribute__((target("avx2")))
+static uint64_t bestKeyAvx2(const unsigned int *d, const double *score,
+                            const uint64_t *key, int count) {
+    unsigned int min_dist = std::numeric_limits<unsigned int>::max();
+    double max_score = -std::numeric_limits<double>::infinity();
+    uint64_t min_key = NAME_KEY_END;
+    unsigned int dist_lanes[8];
+    double score_lanes[4];
+    uint64_t key_lanes[4];
+    int i;
+
+    __m256i dist8 = _mm256_set1_epi32(-1);
+    for (i = 0; i + 8 <= count; i += 8) {
+        dist8 = _mm256_min_epu32(dist8, _mm256_loadu_si256(
+                                            (const __m256i *)(d + i)));
+    }
+    _mm256_storeu_si256((__m256i *)dist_lanes, dist8);
+    for (int lane = 0; lane < 8; ++lane) {
+        min_dist = std::min(min_dist, dist_lanes[lane]);
+    }
+    for (; i < count; ++i) {
+        min_dist = std::min(min_dist, d[i]);
+    }
+
+    if (min_dist == std::numeric_limits<unsigned int>::max()) {
+        return NAME_KEY_END;
+    }
+
+    // 4 distances compared at once, widened to one mask per double
+    __m128i dist4 = _mm_set1_epi32(min_dist);
+    __m256d none = _mm256_set1_pd(-std::numeric_limits<double>::infinity());
+    __m256d score4 = none;
+    for (i = 0; i + 4 <= count; i += 4) {
+        __m256d closest = _mm256_castsi256_pd(_mm256_cvtepi32_epi64(
+            _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(d + i)),
+                            dist4)));
+
+        score4 = _mm256_max_pd(score4, _mm256_blendv_pd(
+                                           none, _mm256_loadu_pd(score + i),
+                                           closest));
+    }
+    _mm256_storeu_pd(score_lanes, score4);
+    for (int lane = 0; lane < 4; ++lane) {
+        max_score = std::max(max_score, score_lanes[lane]);
+    }
+    for (; i < count; ++i) {
+        if (d[i] == min_dist) {
+            max_score = std::max(max_score, score[i]);
+        }
+    }
+
+    // keys are below 2^62, so the signed compare orders them
+    __m256d best_score = _mm256_set1_pd(max_score);
+    __m256i key4 = _mm256_set1_epi64x(NAME_KEY_END), end4 = key4;
+    for (i = 0; i + 4 <= count; i += 4) {
+        __m256d closest = _mm256_castsi256_pd(_mm256_cvtepi32_epi64(
+            _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(d + i)),
+                            dist4)));
+        __m256d best = _mm256_and_pd(closest, _mm256_cmp_pd(
+            _mm256_loadu_pd(score + i), best_score, _CMP_EQ_OQ));
+        __m256i k = _mm256_blendv_epi8(
+            end4, _mm256_loadu_si256((const __m256i *)(key + i)),
+            _mm256_castpd_si256(best));
+
+        key4 = _mm256_blendv_epi8(key4, k, _mm256_cmpgt_epi64(key4, k));
+    }
+    _mm256_storeu_si256((__m256i *)key_lanes, key4);
+    for (int lane = 0; lane < 4; ++lane) {
+        min_key = std::min(min_key, key_lanes[lane]);
+    }
+    for (; i < count; ++i) {
+        if (d[i] == min_dist && score[i] == max_score) {
+            min_key = std::min(min_key, key[i]);
+        }
+    }
+
+    return min_key;
+}
+
+static const bool has_avx2 = __builtin_cpu_supports("avx2");
+#else
+static uint64_t bestKeyAvx2(const unsigned int *d, const double *score,
+                            const uint64_t *key, int count) {
+    return bestKey(d, score, key, count);
+}
+
+static const bool has_avx2 = false;
+#endif
+
+DriverTable::DriverTable(): slot_(), score_(), name_key_(), by_name_(),
+    online_id_(), online_node_(), online_score_(), online_key_(), dist_(),
+    at_node_(), node_slot_() {}
+
+DriverTable::~DriverTable() {}
+
+void DriverTable::reset(int nr_nodes) {
+    slot_.clear();
+    score_.clear();
+    name_key_.clear();
+    by_name_.clear();
+    online_id_.clear();
+    online_node_.clear();
+    online_score_.clear();
+    online_key_.clear();
+    at_node_.assign(nr_nodes, std::vector<int>());
+    node_slot_.clear();
+}
+
+void DriverTable::setKey(int driver, uint64_t key) {
+    name_key_[driver] = key;
+    if (slot_[driver] != -1) {
+        online_key_[slot_[driver]] = key;
+    }
+}
+
+void DriverTable::placeName(std::map<std::string_view, int>::iterator it) {
+    std::map<std::string_view, int>::iterator first = it, last = std::next(it);
+    uint64_t low = (first == by_name_.begin())? 0:
+                   name_key_[std::prev(first)->second];
+    uint64_t high = (last == by_name_.end())? NAME_KEY_END:
+                    name_key_[last->second];
+    uint64_t count = 1;
+
+    if (high - low >= 2) {
+        setKey(it->second, low + (high - low) / 2);
+        return;
+    }
+
+    // the smallest aligned range around low that may hold its names spread
+    // out: a range of 2^bits keys holds at most 2^(bits - bits / 2) - 1
+    for (int bits = 1; ; ++bits) {
+        uint64_t lo = low >> bits << bits, hi = lo + (1ull << bits);
+
+        while (first != by_name_.begin() &&
+               name_key_[std::prev(first)->second] >= lo) {
+            --first;
+            ++count;
+        }
+        while (last != by_name_.end() && name_key_[last->second] < hi) {
+            ++last;
+            ++count;
+        }
+
+        if (bits == 62 || count + 1 <= (1ull << (bits - bits / 2))) {
+            uint64_t step = (hi - lo) / (count + 1), key = lo;
+
+            for (; first != last; ++first) {
+                key += step;
+                setKey(first->second, key);
+            }
+            return;
+        }
+    }
+}
+
+void DriverTable::addDriver(int driver, std::string_view name) {
+    if ((int)slot_.size() <= driver) {
+        slot_.resize(driver + 1, -1);
+        score_.resize(driver + 1, -std::numeric_limits<double>::infinity());
+        name_key_.resize(driver + 1);
+        node_slot_.resize(driver + 1, -1);
+    }
+
+    placeName(by_name_.emplace(name, driver).first);
+}
+
+void DriverTable::setOnline(int driver, int node) {
+    int slot = slot_[driver];
+
+    if (slot == -1) {
+        slot = slot_[driver] = online_id_.size();
+        online_id_.push_back(driver);
+        online_node_.push_back(node);
+        online_score_.push_back(score_[driver]);
+        online_key_.push_back(name_key_[driver]);
+    } else if (online_node_[slot] == node) {
+        return;
+    } else {
+        // leave the old intersection's list
+        std::vector<int>& here = at_node_[online_node_[slot]];
+
+        here[node_slot_[driver]] = here.back();
+        node_slot_[here.back()] = node_slot_[driver];
+        here.pop_back();
+
+        online_node_[slot] = node;
+    }
+
+    node_slot_[driver] = at_node_[node].size();
+    at_node_[node].push_back(driver);
+}
+
+void DriverTable::setOffline(int driver) {
+    int slot = slot_[driver], last = online_id_.size() - 1;
+
+    if (slot == -1) {
+        return;
+    }
+
+    std::vector<int>& here = at_node_[online_node_[slot]];
+
+    here[node_slot_[driver]] = here.back();
+    node_slot_[here.back()] = node_slot_[driver];
+    here.pop_back();
+    node_slot_[driver] = -1;
+
+    // the last online driver takes the freed slot
+    online_id_[slot] = online_id_[last];
+    online_node_[slot] = online_node_[last];
+    online_score_[slot] = online_score_[last];
+    online_key_[slot] = online_key_[last];
+    slot_[online_id_[slot]] = slot;
+
+    online_id_.pop_back();
+    online_node_.pop_back();
+    online_score_.pop_back();
+    online_key_.pop_back();
+    slot_[driver] = -1;
+}
+
+void DriverTable::setRating(int driver, double rating, int nr_races) {
+    score_[driver] = nr_races? rating / nr_races:
+                               -std::numeric_limits<double>::infinity();
+
+    if (slot_[driver] != -1) {
+        online_score_[slot_[driver]] = score_[driver];
+    }
+}
+
+bool DriverTable::isOnline(int driver) const {
+    return driver < (int)slot_.size() && slot_[driver] != -1;
+}
+
+const std::vector<int>& DriverTable::driversAt(int node) const {
+    return at_node_[node];
+}
+
+int DriverTable::getOnline() const {
+    return online_id_.size();
+}
+
+int DriverTable::nearest(const DistMatrix& dist, int src) {
+    // unreachable (-1) turns into the largest unsigned distance
+    dist_.resize(online_id_.size());
+    for (unsigned int i = 0; i < online_id_.size(); ++i) {
+        dist_[i] = dist.getByColumn(online_node_[i], src);
+    }
+
+    return pickNearest();
+}
+
+int DriverTable::nearest(const HubLabels& dist, int src) {
+    dist_.resize(online_id_.size());
+    for (unsigned int i = 0; i < online_id_.size(); ++i) {
+        dist_[i] = dist.get(online_node_[i], src);
+    }
+
+    return pickNearest();
+}
+
+int DriverTable::pickNearest() {
+    uint64_t min_key = has_avx2?
+        bestKeyAvx2(dist_.data(), online_score_.data(), online_key_.data(),
+                    online_id_.size()):
+        bestKey(dist_.data(), online_score_.data(), online_key_.data(),
+                online_id_.size());
+
+    if (min_key == NAME_KEY_END) {
+        return -1;
+    }
+
+    // name keys are unique, so one slot holds min_key
+    for (int i = 0; ; ++i) {
+        if (online_key_[i] == min_key) {
+            return online_id_[i];
+        }
+    }
+}
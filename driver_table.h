@@ -0,0 +1,121 @@
+// Copyright 2019 Nedelcu Horia (nedelcu.horia.alexandru@gmail.com)
+
+/**
+ * driver_table.h
+ */
+
+#ifndef DRIVER_TABLE_H_
+#define DRIVER_TABLE_H_
+
+#include <cstdint>
+#include <map>
+#include <string_view>
+#include <vector>
+#include "./dist_matrix.h"
+#include "./hub_labels.h"
+
+// name keys lie strictly between 0 and this
+#define NAME_KEY_END (1ull << 62)
+
+/**
+ * The drivers as dispatch sees them, and the only record of which ones are
+ * online. Fields are kept as separate arrays, with the online drivers
+ * packed at the front of their own arrays (going offline moves the last
+ * one into the freed slot), and grouped by the intersection they wait at.
+ * Every online change is O(1).
+ *
+ * A driver's score is its average rating, divided once per ride instead of
+ * once per comparison; drivers without rides score -infinity, below every
+ * rated driver. Its name key is a label that grows with the name order,
+ * so a tie on distance and score is broken by one integer compare. Keys
+ * are picked between the neighbouring names' keys and only when two of
+ * those meet is a range around the new name spread out again, each range
+ * sparser than the one it contains, so a new driver costs O(log drivers)
+ * amortized instead of renumbering every name after it.
+ *
+ * nearest() scans the packed arrays three times: a min over the distances,
+ * a max over the scores of the closest drivers and a min over the name keys
+ * of the best of those. On x86-64 CPUs with AVX2 (checked once at startup)
+ * the scans run 8 distances or 4 scores and keys at a time, otherwise as
+ * branchless scalar loops.
+ */
+class DriverTable {
+ private:
+    std::vector<int> slot_;                // driver -> online slot, -1 if off
+    std::vector<double> score_;            // driver -> average rating
+    std::vector<uint64_t> name_key_;       // driver -> name key
+    std::map<std::string_view, int> by_name_;  // name -> driver
+
+    std::vector<int> online_id_;           // online slot -> driver
+    std::vector<int> online_node_;         // online slot -> intersection
+    std::vector<double> online_score_;     // online slot -> score
+    std::vector<uint64_t> online_key_;     // online slot -> name key
+    std::vector<unsigned int> dist_;       // scan scratch
+
+    std::vector<std::vector<int>> at_node_;  // node -> online drivers
+    std::vector<int> node_slot_;             // driver -> index in at_node_
+
+    // Sets the name key of a driver
+    void setKey(int driver, uint64_t key);
+
+    // Gives a name key to a newly added name, spreading out its neighbours
+    void placeName(std::map<std::string_view, int>::iterator it);
+
+    // Return the driver nearest() picks, once dist_ holds the distances
+    int pickNearest();
+
+ public:
+    // Constructor
+    DriverTable();
+
+    // Destructor
+    ~DriverTable();
+
+    /**
+     * Drops every driver and sizes the table for a map.
+     *
+     * @param nr_nodes Number of intersections.
+     */
+    void reset(int nr_nodes);
+
+    /**
+     * Adds an offline driver without rides. O(log drivers) amortized.
+     *
+     * @param driver Id of the driver, the number of drivers added before.
+     * @param name Name of the driver, kept as long as the table.
+     */
+    void addDriver(int driver, std::string_view name);
+
+    // Puts a driver online at an intersection, or moves it there
+    void setOnline(int driver, int node);
+
+    // Takes a driver offline; nothing happens if it is offline already
+    void setOffline(int driver);
+
+    // Sets the ratings sum and number of rides of a driver
+    void setRating(int driver, double rating, int nr_races);
+
+    // Return true if the driver is online
+    bool isOnline(int driver) const;
+
+    // Return the online drivers waiting at an intersection
+    const std::vector<int>& driversAt(int node) const;
+
+    // Return number of online drivers
+    int getOnline() const;
+
+    /**
+     * Finds the online driver that dispatch sends to a client: the closest
+     * one, the best rated among those, the first by name among those.
+     *
+     * @param dist Distances between intersections.
+     * @param src Intersection of the client.
+     * @return the driver, -1 if no online driver can reach src.
+     */
+    int nearest(const DistMatrix& dist, int src);
+
+    // Same as above, with distances taken from hub labels
+    int nearest(const HubLabels& dist, int src);
+};
+
+#endif  // DRIVER_TABLE_H_
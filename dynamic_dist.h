@@ -0,0 +1,328 @@
+// Copyright 2019 Nedelcu Horia (nedelcu.horia.alexandru@gmail.com)
+
+/**
+ * dynamic_dist.h
+ */
+
+#ifndef DYNAMIC_DIST_H_
+#define DYNAMIC_DIST_H_
+
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+/**
+ * Distance rows of the most queried ("hot") sources of a graph, repaired
+ * in place when an edge is added or removed instead of being recomputed.
+ * Sources that are not hot are answered with a point BFS on the graph.
+ * The repairs count hops, so on a weighted graph no row is kept and every
+ * query goes to the graph.
+ *
+ * Tgraph must provide the ListGraph BFS and neighbors interface, and be
+ * frozen, since removals walk the in-neighbors.
+ */
+template <typename Tgraph>
+class DynamicDist {
+ private:
+    struct Row {
+        int src_;
+        unsigned long long last_use_;
+        std::vector<int> dist_;
+    };
+
+    Tgraph *graph_;
+    int capacity_;
+    int hot_after_;
+    unsigned long long clock_;
+
+    std::vector<Row> rows_;
+    std::vector<int> row_of_;  // source -> index in rows_, -1 if none
+    std::vector<int> hits_;    // source -> number of queries so far
+
+    // repair scratch
+    std::vector<int> queue_;
+    std::vector<char> affected_;
+    typename Tgraph::BFSState bfs_;
+
+    // Gets the row of a source, building it if the source just became hot
+    Row *hotRow(int src);
+
+    // Lowers distances in a row after the edge src -> dst was added
+    void repairAdded(std::vector<int>& dist, int src, int dst);
+
+    // Checks if node has an unaffected in-neighbor one level above it
+    bool hasParent(const std::vector<int>& dist, int node);
+
+    // Raises distances in a row after the edge src -> dst was removed
+    void repairRemoved(std::vector<int>& dist, int src, int dst);
+
+ public:
+    /**
+     * Constructor.
+     *
+     * @param graph Graph whose distances are kept.
+     * @param capacity Maximum number of rows kept at once.
+     * @param hot_after Number of queries after which a source gets a row.
+     */
+    DynamicDist(Tgraph *graph, int capacity, int hot_after);
+
+    // Destructor
+    ~DynamicDist();
+
+    // Drops all rows; call after the graph was resized or rebuilt
+    void reset();
+
+    /**
+     * Gets the shortest distance from a node to another node.
+     *
+     * @return distance if there is a path from src to dst, -1 otherwise.
+     */
+    int dist(int src, int dst);
+
+    /**
+     * Gets the cached row of a source, if it has one.
+     *
+     * @return distances from src, or nullptr if src is not hot.
+     */
+    const std::vector<int> *getRow(int src);
+
+    // Repairs the rows; call after the edge src -> dst was added
+    void edgeAdded(int src, int dst);
+
+    // Repairs the rows; call after the edge src -> dst was removed
+    void edgeRemoved(int src, int dst);
+};
+
+template <typename Tgraph>
+DynamicDist<Tgraph>::DynamicDist(Tgraph *graph, int capacity, int hot_after):
+    graph_(graph), capacity_(capacity), hot_after_(hot_after), clock_(0),
+    rows_(), row_of_(), hits_(), queue_(), affected_(), bfs_() {}
+
+template <typename Tgraph>
+DynamicDist<Tgraph>::~DynamicDist() {}
+
+template <typename Tgraph>
+void DynamicDist<Tgraph>::reset() {
+    rows_.clear();
+    row_of_.assign(graph_->getSize(), -1);
+    hits_.assign(graph_->getSize(), 0);
+    affected_.assign(graph_->getSize(), 0);
+}
+
+template <typename Tgraph>
+typename DynamicDist<Tgraph>::Row *DynamicDist<Tgraph>::hotRow(int src) {
+    int index = row_of_[src];
+
+    if (graph_->isWeighted()) {
+        return nullptr;
+    }
+
+    hits_[src]++;
+
+    if (index == -1) {
+        if (hits_[src] < hot_after_ || capacity_ <= 0) {
+            return nullptr;
+        }
+
+        if ((int)rows_.size() < capacity_) {
+            index = rows_.size();
+            rows_.push_back(Row());
+        } else {
+            // the victim is the least queried row, the oldest among equals
+            index = 0;
+            for (unsigned int i = 1; i < rows_.size(); ++i) {
+                if (hits_[rows_[i].src_] < hits_[rows_[index].src_] ||
+                    (hits_[rows_[i].src_] == hits_[rows_[index].src_] &&
+                     rows_[i].last_use_ < rows_[index].last_use_)) {
+                    index = i;
+                }
+            }
+
+            // a row costs a full BFS, only take it for a hotter source
+            if (hits_[src] <= hits_[rows_[index].src_]) {
+                return nullptr;
+            }
+            row_of_[rows_[index].src_] = -1;
+        }
+
+        rows_[index].src_ = src;
+        graph_->getDistNodes(src, rows_[index].dist_, bfs_);
+        row_of_[src] = index;
+    }
+
+    rows_[index].last_use_ = ++clock_;
+    return &rows_[index];
+}
+
+template <typename Tgraph>
+int DynamicDist<Tgraph>::dist(int src, int dst) {
+    Row *row = hotRow(src);
+
+    if (row) {
+        return row->dist_[dst];
+    }
+
+    return graph_->distFrom(src, dst);
+}
+
+template <typename Tgraph>
+const std::vector<int> *DynamicDist<Tgraph>::getRow(int src) {
+    int index = row_of_[src];
+
+    return (index == -1)? nullptr: &rows_[index].dist_;
+}
+
+template <typename Tgraph>
+void DynamicDist<Tgraph>::edgeAdded(int src, int dst) {
+    if (graph_->isWeighted()) {
+        reset();
+        return;
+    }
+
+    for (auto it = rows_.begin(); it != rows_.end(); ++it) {
+        repairAdded(it->dist_, src, dst);
+    }
+}
+
+template <typename Tgraph>
+void DynamicDist<Tgraph>::edgeRemoved(int src, int dst) {
+    if (graph_->isWeighted()) {
+        reset();
+        return;
+    }
+
+    for (auto it = rows_.begin(); it != rows_.end(); ++it) {
+        repairRemoved(it->dist_, src, dst);
+    }
+}
+
+template <typename Tgraph>
+void DynamicDist<Tgraph>::repairAdded(std::vector<int>& dist,
+                                      int src, int dst) {
+    unsigned int head;
+    int node, next;
+
+    if (dist[src] == -1 || (dist[dst] != -1 && dist[dst] <= dist[src] + 1)) {
+        return;
+    }
+
+    // nodes improve in BFS order from dst, each one at most once
+    dist[dst] = dist[src] + 1;
+    queue_.assign(1, dst);
+
+    for (head = 0; head < queue_.size(); ++head) {
+        node = queue_[head];
+
+        for (int i = 0; i < graph_->sizeNeighbors(node); ++i) {
+            next = graph_->neighbor(node, i);
+
+            if (dist[next] == -1 || dist[next] > dist[node] + 1) {
+                dist[next] = dist[node] + 1;
+                queue_.push_back(next);
+            }
+        }
+    }
+}
+
+template <typename Tgraph>
+bool DynamicDist<Tgraph>::hasParent(const std::vector<int>& dist, int node) {
+    int prev;
+
+    for (int i = 0; i < graph_->sizeInNeighbors(node); ++i) {
+        prev = graph_->inNeighbor(node, i);
+
+        if (dist[prev] != -1 && dist[prev] + 1 == dist[node] &&
+            !affected_[prev]) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+template <typename Tgraph>
+void DynamicDist<Tgraph>::repairRemoved(std::vector<int>& dist,
+                                        int src, int dst) {
+    std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>,
+                        std::greater<std::pair<int, int>>> heap;
+    unsigned int head;
+    int node, next, prev, best;
+
+    if (dist[src] == -1 || dist[dst] != dist[src] + 1) {
+        return;  // the edge was not on a shortest path
+    }
+
+    if (hasParent(dist, dst)) {
+        return;  // dst keeps its distance through another in-neighbor
+    }
+
+    // Collect the nodes that lost every shortest-path parent. They are
+    // found level by level, so when a node is checked all the affected
+    // nodes one level above it are already marked.
+    affected_[dst] = 1;
+    queue_.assign(1, dst);
+
+    for (head = 0; head < queue_.size(); ++head) {
+        node = queue_[head];
+
+        for (int i = 0; i < graph_->sizeNeighbors(node); ++i) {
+            next = graph_->neighbor(node, i);
+
+            if (dist[next] == dist[node] + 1 && !affected_[next] &&
+                !hasParent(dist, next)) {
+                affected_[next] = 1;
+                queue_.push_back(next);
+            }
+        }
+    }
+
+    // Give every affected node its best distance through unaffected
+    // in-neighbors, then settle them in distance order.
+    for (head = 0; head < queue_.size(); ++head) {
+        node = queue_[head];
+        best = -1;
+
+        for (int i = 0; i < graph_->sizeInNeighbors(node); ++i) {
+            prev = graph_->inNeighbor(node, i);
+
+            if (!affected_[prev] && dist[prev] != -1 &&
+                (best == -1 || dist[prev] + 1 < best)) {
+                best = dist[prev] + 1;
+            }
+        }
+
+        dist[node] = -1;
+        if (best != -1) {
+            heap.push(std::make_pair(best, node));
+        }
+    }
+
+    while (!heap.empty()) {
+        best = heap.top().first;
+        node = heap.top().second;
+        heap.pop();
+
+        if (!affected_[node]) {
+            continue;  // already settled with a smaller distance
+        }
+
+        affected_[node] = 0;
+        dist[node] = best;
+
+        for (int i = 0; i < graph_->sizeNeighbors(node); ++i) {
+            next = graph_->neighbor(node, i);
+
+            if (affected_[next]) {
+                heap.push(std::make_pair(best + 1, next));
+            }
+        }
+    }
+
+    // the nodes left are no longer reachable
+    for (head = 0; head < queue_.size(); ++head) {
+        affected_[queue_[head]] = 0;
+    }
+}
+
+#endif  // DYNAMIC_DIST_H_
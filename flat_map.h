@@ -0,0 +1,325 @@
+// Copyright 2019 Nedelcu Horia (nedelcu.horia.alexandru@gmail.com)
+
+/**
+ * flat_map.h
+ */
+
+#ifndef FLAT_MAP_H_
+#define FLAT_MAP_H_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "./hashtable.h"
+
+// slots probed together; one control byte each
+#define FLAT_MAP_GROUP 16
+// occupied plus deleted slots kept under this many eighths of the capacity
+#define FLAT_MAP_MAX_LOAD_EIGHTHS 7
+// control bytes of free slots; full slots hold a tag in 0..127
+#define FLAT_MAP_EMPTY ((int8_t)-128)
+#define FLAT_MAP_DELETED ((int8_t)-2)
+
+/**
+ * Open addressing map with the same interface as Hashtable, laid out like
+ * a Swiss table: every slot has a control byte, either EMPTY, DELETED or
+ * 7 bits of the key's hash (its tag). Probing goes a group of 16
+ * control bytes at a time (one SSE2 compare, or a scalar loop without
+ * SSE2) and compares keys only in the slots whose tag matches. A probe
+ * stops at the first group that has an EMPTY slot.
+ */
+template <typename Tkey, typename Tvalue>
+class FlatMap {
+ public:
+    // key type taken by lookups, by the hash function too
+    typedef typename KeyView<Tkey>::type Tview;
+
+ private:
+    std::vector<int8_t> ctrl_;
+    std::vector<struct info<Tkey, Tvalue>> slots_;
+    int size_;
+    int deleted_;
+    int capacity_;
+    int group_mask_;
+    ULL (*hash_)(Tview);
+
+    // groups probed by the key searches, and the most by one of them;
+    // only counted while count_probes_ is set
+    bool count_probes_;
+    long long searches_;
+    long long probes_;
+    int max_probes_;
+
+    // Return a bitmask of the slots of a group whose control byte is value
+    static inline unsigned int matchByte(const int8_t *group, int8_t value);
+
+    // Splits a key's hash in its first group and its tag
+    inline void probeStart(Tview key, int& group, int8_t& tag);
+
+    // Adds a search that probed the given number of groups to the counters
+    inline void countProbes(int);
+
+    // Return the slot of key, -1 if it is not in the map
+    int findSlot(Tview);
+
+    // Return the first empty or deleted slot on a key's probe path
+    int findFree(int group);
+
+    // Moves every key to a map with the given capacity
+    void rehash(int);
+
+ public:
+    // Constructor; capacity is rounded up to a power of two, at least 16
+    FlatMap(int, ULL (*h)(Tview));
+
+    // Destructor
+    ~FlatMap();
+
+    // Return true if the key is in map, false otherwise
+    bool lookup(Tview);
+
+    // Puts value associated with key in map
+    void set(Tview, const Tvalue&);
+
+    // Remove key from map
+    void remove(Tview);
+
+    // Return value associated with key, if it exists
+    Tvalue operator[](Tview);
+
+    // Return numbers of keys from map
+    int getSize();
+
+    // Return the number of slots the map has now
+    int getCapacity();
+
+    // Counts the groups probed by the searches from now on; off by default
+    void setCountProbes(bool);
+
+    // Return number of key searches, lookups and updates alike
+    long long getSearches();
+
+    // Return groups probed by all the searches, and the most by one
+    long long getProbes();
+    int getMaxProbes();
+};
+
+template <typename Tkey, typename Tvalue>
+FlatMap<Tkey, Tvalue>::FlatMap(int capacity, ULL (*h)(Tview)):
+    ctrl_(), slots_(), size_(0), deleted_(0), capacity_(0), group_mask_(0),
+    hash_(h), count_probes_(false), searches_(0), probes_(0),
+    max_probes_(0) {
+    int power = FLAT_MAP_GROUP;
+
+    while (power < capacity) {
+        power <<= 1;
+    }
+
+    rehash(power);
+}
+
+template <typename Tkey, typename Tvalue>
+FlatMap<Tkey, Tvalue>::~FlatMap() {}
+
+template <typename Tkey, typename Tvalue>
+inline unsigned int FlatMap<Tkey, Tvalue>::matchByte(const int8_t *group,
+                                                     int8_t value) {
+#ifdef __SSE2__
+    __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i *>(group));
+
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(value)));
+#else
+    unsigned int mask = 0;
+
+    for (int i = 0; i < FLAT_MAP_GROUP; ++i) {
+        mask |= (unsigned int)(group[i] == value) << i;
+    }
+
+    return mask;
+#endif
+}
+
+template <typename Tkey, typename Tvalue>
+inline void FlatMap<Tkey, Tvalue>::probeStart(Tview key, int& group,
+                                              int8_t& tag) {
+    // group from the top bits of the mixed hash, tag from the middle
+    uint64_t mixed = hash_(key) * 0x9E3779B97F4A7C15ull;
+
+    group = (int)(mixed >> 32) & group_mask_;
+    tag = (int8_t)((mixed >> 25) & 0x7F);
+}
+
+template <typename Tkey, typename Tvalue>
+inline void FlatMap<Tkey, Tvalue>::countProbes(int steps) {
+    if (count_probes_) {
+        searches_++;
+        probes_ += steps;
+        max_probes_ = (steps > max_probes_)? steps: max_probes_;
+    }
+}
+
+template <typename Tkey, typename Tvalue>
+int FlatMap<Tkey, Tvalue>::findSlot(Tview key) {
+    unsigned int mask;
+    int group, slot;
+    int8_t tag;
+
+    probeStart(key, group, tag);
+
+    // groups are visited in triangular order, which covers all of them
+    for (int step = 1; ; ++step) {
+        const int8_t *ctrl = &ctrl_[group * FLAT_MAP_GROUP];
+
+        for (mask = matchByte(ctrl, tag); mask; mask &= mask - 1) {
+            slot = group * FLAT_MAP_GROUP + __builtin_ctz(mask);
+            if (slots_[slot].key == key) {
+                countProbes(step);
+                return slot;
+            }
+        }
+
+        if (matchByte(ctrl, FLAT_MAP_EMPTY)) {
+            countProbes(step);
+            return -1;
+        }
+
+        group = (group + step) & group_mask_;
+    }
+}
+
+template <typename Tkey, typename Tvalue>
+int FlatMap<Tkey, Tvalue>::findFree(int group) {
+    unsigned int mask;
+
+    for (int step = 1; ; ++step) {
+        const int8_t *ctrl = &ctrl_[group * FLAT_MAP_GROUP];
+
+        mask = matchByte(ctrl, FLAT_MAP_EMPTY) |
+               matchByte(ctrl, FLAT_MAP_DELETED);
+        if (mask) {
+            return group * FLAT_MAP_GROUP + __builtin_ctz(mask);
+        }
+
+        group = (group + step) & group_mask_;
+    }
+}
+
+template <typename Tkey, typename Tvalue>
+void FlatMap<Tkey, Tvalue>::rehash(int capacity) {
+    std::vector<int8_t> old_ctrl(capacity, FLAT_MAP_EMPTY);
+    std::vector<struct info<Tkey, Tvalue>> old_slots(capacity);
+    int group, slot;
+    int8_t tag;
+
+    // after the swaps the old_ vectors hold the current keys
+    ctrl_.swap(old_ctrl);
+    slots_.swap(old_slots);
+    capacity_ = capacity;
+    group_mask_ = capacity / FLAT_MAP_GROUP - 1;
+    deleted_ = 0;
+
+    for (unsigned int i = 0; i < old_ctrl.size(); ++i) {
+        if (old_ctrl[i] >= 0) {
+            probeStart(old_slots[i].key, group, tag);
+            slot = findFree(group);
+
+            ctrl_[slot] = tag;
+            slots_[slot] = std::move(old_slots[i]);
+        }
+    }
+}
+
+template <typename Tkey, typename Tvalue>
+bool FlatMap<Tkey, Tvalue>::lookup(Tview key) {
+    return findSlot(key) != -1;
+}
+
+template <typename Tkey, typename Tvalue>
+void FlatMap<Tkey, Tvalue>::set(Tview key, const Tvalue& value) {
+    int slot = findSlot(key), group;
+    int8_t tag;
+
+    if (slot != -1) {  // key is in map
+        slots_[slot].value = value;
+        return;
+    }
+
+    if ((long long)(size_ + deleted_ + 1) * 8 >
+        (long long)capacity_ * FLAT_MAP_MAX_LOAD_EIGHTHS) {
+        // double only if the keys alone fill half of the map
+        rehash((size_ + 1) * 2 > capacity_? capacity_ * 2: capacity_);
+    }
+
+    probeStart(key, group, tag);
+    slot = findFree(group);
+
+    if (ctrl_[slot] == FLAT_MAP_DELETED) {
+        deleted_--;
+    }
+
+    ctrl_[slot] = tag;
+    slots_[slot].key = Tkey(key);
+    slots_[slot].value = value;
+    size_++;
+}
+
+template <typename Tkey, typename Tvalue>
+void FlatMap<Tkey, Tvalue>::remove(Tview key) {
+    int slot = findSlot(key);
+
+    if (slot == -1) {
+        return;
+    }
+
+    // no probe went past a group with an EMPTY slot, so the slot can be
+    // freed for good there; elsewhere it has to stay a tombstone
+    if (matchByte(&ctrl_[slot & ~(FLAT_MAP_GROUP - 1)], FLAT_MAP_EMPTY)) {
+        ctrl_[slot] = FLAT_MAP_EMPTY;
+    } else {
+        ctrl_[slot] = FLAT_MAP_DELETED;
+        deleted_++;
+    }
+    size_--;
+}
+
+template <typename Tkey, typename Tvalue>
+Tvalue FlatMap<Tkey, Tvalue>::operator[](Tview key) {
+    int slot = findSlot(key);
+
+    return (slot != -1)? slots_[slot].value: Tvalue();
+}
+
+template <typename Tkey, typename Tvalue>
+int FlatMap<Tkey, Tvalue>::getSize() {
+    return size_;
+}
+
+template <typename Tkey, typename Tvalue>
+int FlatMap<Tkey, Tvalue>::getCapacity() {
+    return capacity_;
+}
+
+template <typename Tkey, typename Tvalue>
+void FlatMap<Tkey, Tvalue>::setCountProbes(bool enabled) {
+    count_probes_ = enabled;
+}
+
+template <typename Tkey, typename Tvalue>
+long long FlatMap<Tkey, Tvalue>::getSearches() {
+    return searches_;
+}
+
+template <typename Tkey, typename Tvalue>
+long long FlatMap<Tkey, Tvalue>::getProbes() {
+    return probes_;
+}
+
+template <typename Tkey, typename Tvalue>
+int FlatMap<Tkey, Tvalue>::getMaxProbes() {
+    return max_probes_;
+}
+
+#endif  // FLAT_MAP_H_
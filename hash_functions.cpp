@@ -1,25 +1,47 @@
 // Copyright 2019 Nedelcu Horia (nedelcu.horia.alexandru@gmail.com)
 
-#include <string>
+#include <cstring>
+#include <string_view>
 #include "./hash_functions.h"
 
-ULL int_hash(int number) {
-    ULL hash = 5381;
+// Return the xor of the two halves of the 128-bit product a * b
+static inline ULL mix(ULL a, ULL b) {
+    unsigned __int128 product = (unsigned __int128)a * b;
+
+    return (ULL)product ^ (ULL)(product >> 64);
+}
+
+// Return up to 8 bytes of a string as one word, zero padded
+static inline ULL read_word(const char *bytes, size_t count) {
+    ULL word = 0;
 
-    while (number) {
-    	hash = hash * 33 ^ (number % 10);
-    	number /= 10;
+    // an empty string_view may hold a null pointer, not valid for memcpy
+    if (count == 0) {
+        return 0;
     }
 
-    return hash;
+    std::memcpy(&word, bytes, count);
+    return word;
+}
+
+ULL int_hash(int number) {
+    return mix((ULL)(unsigned int)number ^ 0xe7037ed1a0b428dbull,
+               0xa0761d6478bd642full);
 }
 
-ULL string_hash(std::string str) {
-    ULL hash = 5381;
+ULL string_hash(std::string_view str) {
+    const char *bytes = str.data();
+    size_t count = str.size();
+    ULL hash = 0xa0761d6478bd642full ^ count;
 
-    for (unsigned int i = 0; i < str.size(); ++i) {
-        hash = hash * 33 ^ str[i];
+    // wyhash-style: every word is multiplied into the state
+    while (count > 8) {
+        hash = mix(read_word(bytes, 8) ^ 0xe7037ed1a0b428dbull,
+                   hash ^ 0x8ebc6af09c88c6e3ull);
+        bytes += 8;
+        count -= 8;
     }
 
-    return hash;
+    return mix(read_word(bytes, count) ^ 0x589965cc75374cc3ull,
+               hash ^ 0x1d8e4e27c47d124full);
 }
@@ -3,10 +3,12 @@
 #ifndef HASH_FUNCTIONS_H_
 #define HASH_FUNCTIONS_H_
 
-#include <string>
-#define ULL unsigned int
+#include <string_view>
+#define ULL unsigned long long
 
 ULL int_hash(int);
-ULL string_hash(std::string);
+
+// 64-bit hash of a string, read 8 bytes at a time; never allocates
+ULL string_hash(std::string_view);
 
 #endif  // HASH_FUNCTIONS_H_
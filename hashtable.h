@@ -3,87 +3,183 @@
 #ifndef HASHTABLE_H_
 #define HASHTABLE_H_
 
+#include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
-#define ULL unsigned int
-#define PRIME_CAPACITY_FOR_HASH 666013
+#define ULL unsigned long long
+// capacity of a new table; it doubles as keys are added
+#define HASH_INITIAL_CAPACITY 16
+// occupied plus lazy deleted slots kept under this percent of the capacity
+#define HASH_MAX_LOAD_PERCENT 70
 
 enum SlotType {Empty, Occupied, Lazy_Delete};
 
+/**
+ * Type keys are looked up and hashed by. Strings are looked up by
+ * std::string_view, so a token does not have to become a std::string
+ * first; a std::string is only built when a new key is stored.
+ */
+template <typename Tkey>
+struct KeyView {
+    typedef const Tkey& type;
+};
+
+template <>
+struct KeyView<std::string> {
+    typedef std::string_view type;
+};
+
+template <>
+struct KeyView<std::string_view> {
+    typedef std::string_view type;
+};
+
 template <typename Tkey, typename Tvalue>
 struct info {
     Tkey key;
     Tvalue value;
 };
 
+/**
+ * Open addressing hashtable with linear probing. The capacity is a power
+ * of two: when occupied and lazy deleted slots pass HASH_MAX_LOAD_PERCENT
+ * the table is rehashed, doubled if the keys alone need it, and the lazy
+ * deleted slots are dropped.
+ */
 template <typename Tkey, typename Tvalue>
 class Hashtable {
+ public:
+    // key type taken by lookups, by the hash function too
+    typedef typename KeyView<Tkey>::type Tview;
+
  private:
     std::vector<struct info<Tkey, Tvalue>> hash_table_;
     std::vector<SlotType> slot_;
     int size_;
+    int deleted_;
     int capacity_;
-    ULL (*hash_)(Tkey);
+    int shift_;
+    ULL (*hash_)(Tview);
+
+    // Return the first slot probed for a key
+    inline int home(Tview);
+
+    // Moves every key to a table with the given capacity
+    void rehash(int);
 
  public:
-    // Constructor
-    Hashtable(int, ULL (*h)(Tkey));
+    // Constructor; capacity is rounded up to a power of two
+    Hashtable(int, ULL (*h)(Tview));
 
     // Destructor
     ~Hashtable();
 
-    // Find an empty slot if it exists for insertion
-    int findSlotInsert(const Tkey&);
+    // Find the slot of key, or else the first free one on its probe path
+    int findSlotInsert(Tview);
 
     // Return the index's slot of key to be searched
-    int findSlotSearch(const Tkey&);
+    int findSlotSearch(Tview);
 
     // Return true if the key is in hashtable, false otherwise
-    bool lookup(const Tkey&);
+    bool lookup(Tview);
 
     // Puts value associated with key in hashtable
-    void set(const Tkey&, const Tvalue&);
+    void set(Tview, const Tvalue&);
 
     // Remove key from hashtable
-    void remove(const Tkey&);
+    void remove(Tview);
 
     // Return value associated with key, if it exists
-    Tvalue operator[](const Tkey&);
+    Tvalue operator[](Tview);
 
     // Return numbers of keys from hashtable
     int getSize();
 
-    // Return the maximum numbers of keys that hashtable can hold
+    // Return the number of slots the hashtable has now
     int getCapacity();
 };
 
 template <typename Tkey, typename Tvalue>
-Hashtable<Tkey, Tvalue>::Hashtable(int capacity, ULL (*h)(Tkey)):
-    hash_table_(capacity), slot_(capacity, SlotType::Empty),
-    size_(0), capacity_(capacity), hash_(h) {}
+Hashtable<Tkey, Tvalue>::Hashtable(int capacity, ULL (*h)(Tview)):
+    hash_table_(), slot_(), size_(0), deleted_(0), capacity_(0), shift_(0),
+    hash_(h) {
+    int power = 8;
+
+    while (power < capacity) {
+        power <<= 1;
+    }
+
+    rehash(power);
+}
 
 template <typename Tkey, typename Tvalue>
 Hashtable<Tkey, Tvalue>::~Hashtable() {}
 
 template <typename Tkey, typename Tvalue>
-int Hashtable<Tkey, Tvalue>::findSlotInsert(const Tkey& key) {
-    int i = hash_(key) % capacity_;
+inline int Hashtable<Tkey, Tvalue>::home(Tview key) {
+    // Fibonacci hashing: the top bits of the product mix every hash bit
+    return (hash_(key) * 0x9E3779B97F4A7C15ull) >> shift_;
+}
+
+template <typename Tkey, typename Tvalue>
+void Hashtable<Tkey, Tvalue>::rehash(int capacity) {
+    std::vector<struct info<Tkey, Tvalue>> old_table(capacity);
+    std::vector<SlotType> old_slot(capacity, SlotType::Empty);
+    int i;
+
+    // after the swaps the old_ vectors hold the current keys
+    hash_table_.swap(old_table);
+    slot_.swap(old_slot);
+    capacity_ = capacity;
+    deleted_ = 0;
+
+    for (shift_ = 64; capacity > 1; capacity >>= 1) {
+        shift_--;
+    }
+
+    for (unsigned int j = 0; j < old_slot.size(); ++j) {
+        if (old_slot[j] == SlotType::Occupied) {
+            i = home(old_table[j].key);
+            while (slot_[i] != SlotType::Empty) {
+                i = (i + 1) & (capacity_ - 1);
+            }
+
+            hash_table_[i] = std::move(old_table[j]);
+            slot_[i] = SlotType::Occupied;
+        }
+    }
+}
+
+template <typename Tkey, typename Tvalue>
+int Hashtable<Tkey, Tvalue>::findSlotInsert(Tview key) {
+    int i = home(key), first_free = -1;
 
     // search until we either find the key, or find an empty slot.
-    while (slot_[i] == SlotType::Occupied && hash_table_[i].key != key) {
-        i = (i + 1) % capacity_;
+    while (slot_[i] != SlotType::Empty) {
+        if (slot_[i] == SlotType::Occupied) {
+            if (hash_table_[i].key == key) {
+                return i;
+            }
+        } else if (first_free == -1) {
+            first_free = i;
+        }
+
+        i = (i + 1) & (capacity_ - 1);
     }
 
-    // Cases found: Empty slot, Lazy_Delete slot, slot[i].key equal with key
-    return i;
+    // the key is not in table: reuse the first Lazy_Delete slot passed
+    return (first_free != -1)? first_free: i;
 }
 
 template <typename Tkey, typename Tvalue>
-int Hashtable<Tkey, Tvalue>::findSlotSearch(const Tkey& key) {
-    int i = hash_(key) % capacity_;
+int Hashtable<Tkey, Tvalue>::findSlotSearch(Tview key) {
+    int i = home(key);
 
     // search until we either find the key, or find an empty slot.
-    while (slot_[i] != SlotType::Empty && hash_table_[i].key != key) {
-        i = (i + 1) % capacity_;
+    while (slot_[i] != SlotType::Empty &&
+           (slot_[i] != SlotType::Occupied || hash_table_[i].key != key)) {
+        i = (i + 1) & (capacity_ - 1);
     }
 
     // Cases found: Empty slot (passed all Occupied and Lazy_Delet slots),
@@ -92,7 +188,7 @@ int Hashtable<Tkey, Tvalue>::findSlotSearch(const Tkey& key) {
 }
 
 template <typename Tkey, typename Tvalue>
-bool Hashtable<Tkey, Tvalue>::lookup(const Tkey& key) {
+bool Hashtable<Tkey, Tvalue>::lookup(Tview key) {
     int i = findSlotSearch(key);
 
     if (slot_[i] == SlotType::Occupied) {  // key is in table
@@ -103,25 +199,42 @@ bool Hashtable<Tkey, Tvalue>::lookup(const Tkey& key) {
 }
 
 template <typename Tkey, typename Tvalue>
-void Hashtable<Tkey, Tvalue>::set(const Tkey& key, const Tvalue& value) {
+void Hashtable<Tkey, Tvalue>::set(Tview key, const Tvalue& value) {
     int i = findSlotInsert(key);
 
-    hash_table_[i].key = key;
+    if (slot_[i] == SlotType::Occupied) {  // key is in table
+        hash_table_[i].value = value;
+        return;
+    }
+
+    if (slot_[i] == SlotType::Lazy_Delete) {
+        deleted_--;
+    } else if ((long long)(size_ + deleted_ + 1) * 100 >
+               (long long)capacity_ * HASH_MAX_LOAD_PERCENT) {
+        // double only if the keys alone fill half of the table
+        rehash((size_ + 1) * 2 > capacity_? capacity_ * 2: capacity_);
+        i = findSlotInsert(key);
+    }
+
+    hash_table_[i].key = Tkey(key);
     hash_table_[i].value = value;
     slot_[i] = SlotType::Occupied;
+    size_++;
 }
 
 template <typename Tkey, typename Tvalue>
-void Hashtable<Tkey, Tvalue>::remove(const Tkey& key) {
-    int i = findSlotInsert(key);
+void Hashtable<Tkey, Tvalue>::remove(Tview key) {
+    int i = findSlotSearch(key);
 
     if (slot_[i] == SlotType::Occupied) {  // key is in the table
         slot_[i] = SlotType::Lazy_Delete;
+        size_--;
+        deleted_++;
     }
 }
 
 template <typename Tkey, typename Tvalue>
-Tvalue Hashtable<Tkey, Tvalue>::operator[](const Tkey& key) {
+Tvalue Hashtable<Tkey, Tvalue>::operator[](Tview key) {
     int i = findSlotSearch(key);
 
     if (slot_[i] == SlotType::Occupied) {  // key is in table
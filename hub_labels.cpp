@@ -0,0 +1,155 @@
+// Copyright 2019 Nedelcu Horia (nedelcu.horia.alexandru@gmail.com)
+
+#include <algorithm>
+#include <vector>
+#include "./hub_labels.h"
+
+HubLabels::HubLabels(): out_offsets_(), out_labels_(), in_offsets_(),
+    in_labels_(), dist_(), own_dist_(), touched_(), buckets_() {}
+
+HubLabels::~HubLabels() {}
+
+void HubLabels::prunedSearch(int hub, int rank, const Adjacency& adj,
+                             int max_weight, const std::vector<Entry>& own,
+                             std::vector<std::vector<Entry>>& labels) {
+    int nr_buckets = max_weight + 1, node, next;
+    long long pending = 1;
+    bool pruned;
+
+    for (auto it = own.begin(); it != own.end(); ++it) {
+        own_dist_[it->hub] = it->dist;
+    }
+
+    buckets_.resize(nr_buckets);
+    dist_[hub] = 0;
+    touched_.assign(1, hub);
+    buckets_[0].assign(1, hub);
+
+    // a weight is below nr_buckets, so no edge leads back into the bucket
+    // being settled
+    for (int d = 0; pending; ++d) {
+        std::vector<int>& bucket = buckets_[d % nr_buckets];
+
+        pending -= bucket.size();
+
+        for (unsigned int i = 0; i < bucket.size(); ++i) {
+            node = bucket[i];
+            if (dist_[node] != d) {  // reached closer after it was queued
+                continue;
+            }
+
+            pruned = false;
+            for (auto it = labels[node].begin(); it != labels[node].end() &&
+                !pruned; ++it) {
+                pruned = own_dist_[it->hub] != -1 &&
+                         own_dist_[it->hub] + it->dist <= d;
+            }
+
+            if (pruned) {
+                continue;
+            }
+
+            labels[node].push_back(Entry{rank, d});
+
+            for (int e = adj.offsets[node];
+                e < adj.offsets[node] + adj.degree[node]; ++e) {
+                next = d + (adj.weights? adj.weights[e]: 1);
+
+                if (dist_[adj.targets[e]] == -1) {
+                    touched_.push_back(adj.targets[e]);
+                } else if (dist_[adj.targets[e]] <= next) {
+                    continue;
+                }
+
+                dist_[adj.targets[e]] = next;
+                buckets_[next % nr_buckets].push_back(adj.targets[e]);
+                pending++;
+            }
+        }
+
+        bucket.clear();
+    }
+
+    for (auto it = touched_.begin(); it != touched_.end(); ++it) {
+        dist_[*it] = -1;
+    }
+
+    for (auto it = own.begin(); it != own.end(); ++it) {
+        own_dist_[it->hub] = -1;
+    }
+}
+
+void HubLabels::pack(std::vector<std::vector<Entry>>& lists,
+                     std::vector<int>& offsets, std::vector<Entry>& labels) {
+    size_t total = 0;
+
+    for (auto it = lists.begin(); it != lists.end(); ++it) {
+        total += it->size();
+    }
+
+    offsets.assign(lists.size() + 1, 0);
+    labels.clear();
+    labels.reserve(total);
+
+    for (unsigned int i = 0; i < lists.size(); ++i) {
+        offsets[i] = labels.size();
+        labels.insert(labels.end(), lists[i].begin(), lists[i].end());
+        std::vector<Entry>().swap(lists[i]);
+    }
+    offsets[lists.size()] = labels.size();
+}
+
+void HubLabels::build(int size, const Adjacency& out, const Adjacency& in,
+                      int max_weight) {
+    std::vector<std::vector<Entry>> out_lists(size), in_lists(size);
+    std::vector<int> order(size);
+
+    clear();
+
+    // hubs by decreasing degree: they cover the most shortest paths
+    for (int i = 0; i < size; ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        return out.degree[a] + in.degree[a] > out.degree[b] + in.degree[b];
+    });
+
+    dist_.assign(size, -1);
+    own_dist_.assign(size, -1);
+
+    for (int rank = 0; rank < size; ++rank) {
+        // forward: hubs the node is reached from; backward: hubs it reaches
+        prunedSearch(order[rank], rank, out, max_weight,
+                     out_lists[order[rank]], in_lists);
+        prunedSearch(order[rank], rank, in, max_weight,
+                     in_lists[order[rank]], out_lists);
+    }
+
+    pack(out_lists, out_offsets_, out_labels_);
+    pack(in_lists, in_offsets_, in_labels_);
+
+    std::vector<int>().swap(dist_);
+    std::vector<int>().swap(own_dist_);
+    std::vector<int>().swap(touched_);
+    std::vector<std::vector<int>>().swap(buckets_);
+}
+
+void HubLabels::clear() {
+    std::vector<int>().swap(out_offsets_);
+    std::vector<Entry>().swap(out_labels_);
+    std::vector<int>().swap(in_offsets_);
+    std::vector<Entry>().swap(in_labels_);
+}
+
+bool HubLabels::isBuilt() const {
+    return !out_offsets_.empty();
+}
+
+size_t HubLabels::getEntries() const {
+    return out_labels_.size() + in_labels_.size();
+}
+
+size_t HubLabels::getBytes() const {
+    return (out_offsets_.size() + in_offsets_.size()) * sizeof(int) +
+           getEntries() * sizeof(Entry);
+}
@@ -0,0 +1,159 @@
+// Copyright 2019 Nedelcu Horia (nedelcu.horia.alexandru@gmail.com)
+
+/**
+ * hub_labels.h
+ */
+
+#ifndef HUB_LABELS_H_
+#define HUB_LABELS_H_
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * 2-hop distance labels of a directed graph, built by pruned landmark
+ * labeling. Nodes become hubs one at a time, by decreasing degree; each
+ * node keeps an out-label (hubs it reaches, with their distance) and an
+ * in-label (hubs that reach it), both sorted by hub rank, so that every
+ * shortest path u -> v passes through a hub of out(u) and in(v). A
+ * distance is then the merge of two short arrays, and the memory grows
+ * with the label sizes instead of with the square of the nodes.
+ *
+ * The search from each hub is pruned where the labels found so far
+ * already give the distance, which is what keeps the labels short.
+ */
+class HubLabels {
+ public:
+    // A CSR adjacency the way ListGraph keeps it
+    struct Adjacency {
+        const int *offsets;
+        const int *degree;
+        const int *targets;
+        const int *weights;  // parallel to targets, nullptr if all are 1
+    };
+
+ private:
+    // A hub (by rank) and its distance
+    struct Entry {
+        int hub;
+        int dist;
+    };
+
+    // label of node i: labels[offsets[i]] up to labels[offsets[i + 1] - 1]
+    std::vector<int> out_offsets_;
+    std::vector<Entry> out_labels_;
+    std::vector<int> in_offsets_;
+    std::vector<Entry> in_labels_;
+
+    // build scratch: distances of the current search, -1 if not reached;
+    // hub rank -> distance in the hub's own label, -1 if not there
+    std::vector<int> dist_;
+    std::vector<int> own_dist_;
+    std::vector<int> touched_;
+    std::vector<std::vector<int>> buckets_;
+
+    /**
+     * Pruned shortest paths from one hub (Dial's buckets, so BFS order on
+     * unit weights). A node reached at distance d whose labels already
+     * give d or less is neither labeled nor expanded.
+     *
+     * @param hub Node the search starts from.
+     * @param rank Rank of the hub, stored in the new entries.
+     * @param adj Edges followed: the out-edges to fill in-labels, the
+     * in-edges to fill out-labels.
+     * @param max_weight Largest weight in adj.
+     * @param own Label of the hub on the other side.
+     * @param labels Labels that get the new entries.
+     */
+    void prunedSearch(int hub, int rank, const Adjacency& adj,
+                      int max_weight, const std::vector<Entry>& own,
+                      std::vector<std::vector<Entry>>& labels);
+
+    // Packs per-node labels into offsets and one array
+    static void pack(std::vector<std::vector<Entry>>& lists,
+                     std::vector<int>& offsets, std::vector<Entry>& labels);
+
+ public:
+    // Constructor
+    HubLabels();
+
+    // Destructor
+    ~HubLabels();
+
+    /**
+     * Builds the labels.
+     *
+     * @param size Number of nodes.
+     * @param out Out-edges of the graph.
+     * @param in In-edges of the graph, with the same weights.
+     * @param max_weight Largest edge weight, 1 for an unweighted graph.
+     */
+    void build(int size, const Adjacency& out, const Adjacency& in,
+               int max_weight);
+
+    // Frees the labels; isBuilt() is false until the next build
+    void clear();
+
+    // Return true if the labels were built and not cleared since
+    bool isBuilt() const;
+
+    /**
+     * Gets the shortest distance from a node to another node.
+     *
+     * @return distance from src to dst, -1 if there is no path.
+     */
+    inline int get(int src, int dst) const;
+
+    // Return number of label entries, both sides
+    size_t getEntries() const;
+
+    // Return memory used by the labels
+    size_t getBytes() const;
+};
+
+inline int HubLabels::get(int src, int dst) const {
+    const Entry *out = out_labels_.data() + out_offsets_[src];
+    const Entry *out_end = out_labels_.data() + out_offsets_[src + 1];
+    const Entry *in = in_labels_.data() + in_offsets_[dst];
+    const Entry *in_end = in_labels_.data() + in_offsets_[dst + 1];
+    int best = -1;
+
+    // both labels are sorted by hub rank
+    while (out != out_end && in != in_end) {
+        if (out->hub < in->hub) {
+            ++out;
+        } else if (out->hub > in->hub) {
+            ++in;
+        } else {
+            if (best == -1 || out->dist + in->dist < best) {
+                best = out->dist + in->dist;
+            }
+            ++out;
+            ++in;
+        }
+    }
+
+    return best;
+}
+
+/**
+ * Builds the 2-hop labels of a frozen graph (a ListGraph) from its CSR
+ * rows in both directions, with its weights. The labels are not updated by
+ * later edge changes.
+ *
+ * @param graph Frozen graph.
+ * @param labels Labels that get built.
+ */
+template <typename Graph>
+void buildHubLabels(Graph& graph, HubLabels& labels) {
+    typename Graph::CSR out = graph.getCSR(false), in = graph.getCSR(true);
+
+    labels.build(graph.getSize(),
+                 HubLabels::Adjacency{out.offsets, out.degree, out.targets,
+                                      out.weights},
+                 HubLabels::Adjacency{in.offsets, in.degree, in.targets,
+                                      in.weights},
+                 graph.getMaxWeight());
+}
+
+#endif  // HUB_LABELS_H_
@@ -0,0 +1,200 @@
+// Copyright 2019 Nedelcu Horia (nedelcu.horia.alexandru@gmail.com)
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <charconv>
+#include <istream>
+#include <string_view>
+#include <vector>
+#include "./input_reader.h"
+#include "./stream_fd.h"
+
+InputReader::InputReader(const char *path): begin_(nullptr), pos_(nullptr),
+    end_(nullptr), map_(nullptr), map_size_(0), buffer_(), open_(false) {
+    int fd = open(path, O_RDONLY);
+
+    if (fd == -1) {
+        return;
+    }
+
+    if (mapFile(fd, 0)) {
+        open_ = true;
+    } else {
+        // not seekable, or the mapping failed: copy it
+        open_ = readAll(fd);
+        begin_ = buffer_.data();
+        end_ = begin_ + buffer_.size();
+        pos_ = begin_;
+    }
+
+    close(fd);
+}
+
+InputReader::InputReader(std::istream& stream): begin_(nullptr),
+    pos_(nullptr), end_(nullptr), map_(nullptr), map_size_(0), buffer_(),
+    open_(false) {
+    int fd = streamFd(stream);
+
+    // a file stream's file is mapped from where the stream stands
+    if (fd != -1) {
+        std::streamoff offset = stream.tellg();
+
+        if (offset >= 0 && mapFile(fd, offset)) {
+            open_ = true;
+            stream.setstate(std::ios_base::eofbit);
+            return;
+        }
+    }
+
+    open_ = readAll(stream);
+    begin_ = buffer_.data();
+    end_ = begin_ + buffer_.size();
+    pos_ = begin_;
+}
+
+InputReader::~InputReader() {
+    if (map_) {
+        munmap(map_, map_size_);
+    }
+}
+
+bool InputReader::mapFile(int fd, off_t offset) {
+    struct stat info;
+
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) ||
+        info.st_size <= offset) {
+        return false;
+    }
+
+    map_ = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map_ == MAP_FAILED) {
+        map_ = nullptr;
+        return false;
+    }
+
+    map_size_ = info.st_size;
+    madvise(map_, map_size_, MADV_SEQUENTIAL);
+
+    begin_ = static_cast<const char *>(map_) + offset;
+    end_ = static_cast<const char *>(map_) + map_size_;
+    pos_ = begin_;
+    return true;
+}
+
+bool InputReader::readAll(int fd) {
+    size_t size = 0;
+    ssize_t count;
+
+    buffer_.resize(1 << 16);
+
+    while ((count = read(fd, buffer_.data() + size,
+                         buffer_.size() - size)) != 0) {
+        if (count < 0) {
+            buffer_.clear();
+            return false;
+        }
+
+        size += count;
+        if (size == buffer_.size()) {
+            buffer_.resize(size * 2);
+        }
+    }
+
+    buffer_.resize(size);
+    return true;
+}
+
+bool InputReader::readAll(std::istream& stream) {
+    std::streambuf *source = stream.rdbuf();
+    std::streamsize count;
+    size_t size = 0;
+
+    if (!source) {
+        return false;
+    }
+
+    buffer_.resize(1 << 16);
+
+    // sgetn bypasses the stream's own buffer for reads this large
+    while ((count = source->sgetn(buffer_.data() + size,
+                                  buffer_.size() - size)) > 0) {
+        size += count;
+        if (size == buffer_.size()) {
+            buffer_.resize(size * 2);
+        }
+    }
+
+    buffer_.resize(size);
+    stream.setstate(std::ios_base::eofbit);
+    return true;
+}
+
+bool InputReader::isOpen() const {
+    return open_;
+}
+
+bool InputReader::eof() {
+    skipSpaces();
+    return pos_ == end_;
+}
+
+bool InputReader::accept(std::string_view word) {
+    const char *start;
+
+    skipSpaces();
+    start = pos_;
+
+    if (token() == word) {
+        return true;
+    }
+
+    pos_ = start;
+    return false;
+}
+
+std::string_view InputReader::token() {
+    const char *start;
+
+    skipSpaces();
+    start = pos_;
+
+    while (pos_ != end_ && *pos_ != ' ' && *pos_ != '\n' && *pos_ != '\r' &&
+           *pos_ != '\t' && *pos_ != '\v' && *pos_ != '\f') {
+        ++pos_;
+    }
+
+    return std::string_view(start, pos_ - start);
+}
+
+InputReader& InputReader::operator>>(int& value) {
+    std::string_view text = token();
+
+    // from_chars takes no leading '+', istream does
+    if (!text.empty() && text[0] == '+') {
+        text.remove_prefix(1);
+    }
+
+    if (std::from_chars(text.data(), text.data() + text.size(),
+                        value).ec != std::errc()) {
+        value = 0;
+    }
+
+    return *this;
+}
+
+InputReader& InputReader::operator>>(double& value) {
+    std::string_view text = token();
+
+    if (!text.empty() && text[0] == '+') {
+        text.remove_prefix(1);
+    }
+
+    if (std::from_chars(text.data(), text.data() + text.size(),
+                        value).ec != std::errc()) {
+        value = 0;
+    }
+
+    return *this;
+}
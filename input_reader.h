@@ -0,0 +1,109 @@
+// Copyright 2019 Nedelcu Horia (nedelcu.horia.alexandru@gmail.com)
+
+/**
+ * input_reader.h
+ */
+
+#ifndef INPUT_READER_H_
+#define INPUT_READER_H_
+
+#include <sys/types.h>
+#include <charconv>
+#include <cstddef>
+#include <istream>
+#include <string_view>
+#include <vector>
+
+/**
+ * Whole-file input split in whitespace separated tokens. A regular file is
+ * mmapped, whether it is opened by path or by a std::ifstream (mapped from
+ * where the stream stands, through the stream's descriptor); anything that
+ * cannot be (a pipe, a terminal, a stream that is not a file) is read to
+ * the end into a buffer instead. Either way tokens are std::string_views
+ * into the input, valid as long as the reader, and numbers are parsed in
+ * place with std::from_chars, without locales or allocations.
+ */
+class InputReader {
+ private:
+    const char *begin_;
+    const char *pos_;
+    const char *end_;
+    void *map_;                 // mmapped file, nullptr if buffer_ is used
+    size_t map_size_;
+    std::vector<char> buffer_;  // fallback copy of the input
+    bool open_;
+
+    // Moves pos_ past spaces, tabs and newlines
+    inline void skipSpaces();
+
+    // Maps a regular file and starts at offset; return false if it cannot
+    bool mapFile(int fd, off_t offset);
+
+    // Reads a descriptor to the end into buffer_
+    bool readAll(int fd);
+
+    // Reads a stream to the end into buffer_
+    bool readAll(std::istream& stream);
+
+ public:
+    // Constructor; isOpen() tells if the file could be read
+    explicit InputReader(const char *path);
+
+    // Constructor; maps or reads the rest of the stream
+    explicit InputReader(std::istream& stream);
+
+    // Destructor; unmaps the file
+    ~InputReader();
+
+    InputReader(const InputReader&) = delete;
+    InputReader& operator=(const InputReader&) = delete;
+
+    // Return true if the input was opened
+    bool isOpen() const;
+
+    // Return true if only whitespace is left
+    bool eof();
+
+    // Reads the next token if it is word; return true if it was
+    bool accept(std::string_view word);
+
+    /**
+     * Gets the next token.
+     *
+     * @return the token, empty at the end of the input.
+     */
+    std::string_view token();
+
+    // Reads the next token, like std::istream >> std::string does
+    inline InputReader& operator>>(std::string_view& value);
+
+    // Reads the next non-whitespace character
+    inline InputReader& operator>>(char& value);
+
+    // Reads a decimal integer; 0 if the token is not one
+    InputReader& operator>>(int& value);
+
+    // Reads a floating point number; 0 if the token is not one
+    InputReader& operator>>(double& value);
+};
+
+inline void InputReader::skipSpaces() {
+    while (pos_ != end_ && (*pos_ == ' ' || *pos_ == '\n' ||
+                            *pos_ == '\r' || *pos_ == '\t' ||
+                            *pos_ == '\v' || *pos_ == '\f')) {
+        ++pos_;
+    }
+}
+
+inline InputReader& InputReader::operator>>(std::string_view& value) {
+    value = token();
+    return *this;
+}
+
+inline InputReader& InputReader::operator>>(char& value) {
+    skipSpaces();
+    value = (pos_ != end_)? *pos_++: '\0';
+    return *this;
+}
+
+#endif  // INPUT_READER_H_
@@ -0,0 +1,66 @@
+// Copyright 2019 Nedelcu Horia (nedelcu.horia.alexandru@gmail.com)
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <vector>
+#include "./latency_histogram.h"
+
+LatencyHistogram::LatencyHistogram():
+    buckets_(bucketOf(UINT64_MAX) + 1, 0), count_(0), sum_(0), max_(0) {}
+
+LatencyHistogram::~LatencyHistogram() {}
+
+uint64_t LatencyHistogram::bucketTop(int bucket) {
+    int shift;
+    uint64_t mantissa;
+
+    if (bucket < (2 << LATENCY_SUB_BITS)) {
+        return bucket;
+    }
+
+    // inverse of bucketOf
+    shift = (bucket >> LATENCY_SUB_BITS) - 1;
+    mantissa = bucket - (shift << LATENCY_SUB_BITS);
+    return ((mantissa + 1) << shift) - 1;
+}
+
+uint64_t LatencyHistogram::getCount() const {
+    return count_;
+}
+
+uint64_t LatencyHistogram::percentile(double p) const {
+    uint64_t rank, seen = 0;
+
+    if (!count_) {
+        return 0;
+    }
+
+    // nearest rank: the smallest sample with at least p% of them at or below
+    rank = std::max<uint64_t>(1, std::ceil(p * count_ / 100.0));
+
+    for (unsigned int i = 0; i < buckets_.size(); ++i) {
+        seen += buckets_[i];
+        if (seen >= rank || seen == count_) {
+            return (bucketTop(i) < max_)? bucketTop(i): max_;
+        }
+    }
+
+    return max_;
+}
+
+void LatencyHistogram::report(std::ostream& out, const char *name) const {
+    if (!count_) {
+        return;
+    }
+
+    out << std::fixed << std::setprecision(3) << name << ": " << count_
+        << " events, us mean " << sum_ / 1000.0 / count_
+        << " p50 " << percentile(50) / 1000.0
+        << " p90 " << percentile(90) / 1000.0
+        << " p99 " << percentile(99) / 1000.0
+        << " p99.9 " << percentile(99.9) / 1000.0
+        << " max " << max_ / 1000.0 << '\n';
+}
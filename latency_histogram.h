@@ -0,0 +1,113 @@
+// Copyright 2019 Nedelcu Horia (nedelcu.horia.alexandru@gmail.com)
+
+/**
+ * latency_histogram.h
+ */
+
+#ifndef LATENCY_HISTOGRAM_H_
+#define LATENCY_HISTOGRAM_H_
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// linear sub-buckets per power of two: values are kept within 1/8
+#define LATENCY_SUB_BITS 3
+
+/**
+ * Log-bucketed histogram of latencies in nanoseconds, HDR style: every
+ * power of two is split in 8 equal buckets, so a percentile is off by at
+ * most 12.5% whatever the magnitude, and recording is a few shifts.
+ */
+class LatencyHistogram {
+ private:
+    std::vector<uint64_t> buckets_;
+    uint64_t count_;
+    uint64_t sum_;
+    uint64_t max_;
+
+    // Return the bucket of a value
+    static inline int bucketOf(uint64_t value);
+
+    // Return the largest value that falls in a bucket
+    static uint64_t bucketTop(int bucket);
+
+ public:
+    // Constructor
+    LatencyHistogram();
+
+    // Destructor
+    ~LatencyHistogram();
+
+    // Adds a latency, in nanoseconds
+    inline void record(uint64_t value);
+
+    // Return number of latencies recorded
+    uint64_t getCount() const;
+
+    /**
+     * Gets a percentile (nearest rank) of the latencies recorded.
+     *
+     * @param p Percentile, in 0..100.
+     * @return upper bound of the bucket holding it, 0 if nothing recorded.
+     */
+    uint64_t percentile(double p) const;
+
+    /**
+     * Prints one line: count, mean, p50, p90, p99, p99.9 and max, in
+     * microseconds; nothing if nothing was recorded.
+     */
+    void report(std::ostream& out, const char *name) const;
+};
+
+/**
+ * Records the time from its construction to its destruction, so every way
+ * out of a scope is measured. A null histogram turns it off.
+ */
+class ScopedLatency {
+ private:
+    LatencyHistogram *histogram_;
+    std::chrono::steady_clock::time_point start_;
+
+ public:
+    explicit ScopedLatency(LatencyHistogram *histogram);
+
+    ~ScopedLatency();
+};
+
+inline int LatencyHistogram::bucketOf(uint64_t value) {
+    int exponent;
+
+    if (value < (2u << LATENCY_SUB_BITS)) {
+        return value;
+    }
+
+    // position of the top bit, then the next LATENCY_SUB_BITS bits
+    exponent = 63 - __builtin_clzll(value);
+    return ((exponent - LATENCY_SUB_BITS) << LATENCY_SUB_BITS) +
+           (value >> (exponent - LATENCY_SUB_BITS));
+}
+
+inline void LatencyHistogram::record(uint64_t value) {
+    buckets_[bucketOf(value)]++;
+    count_++;
+    sum_ += value;
+    max_ = (value > max_)? value: max_;
+}
+
+inline ScopedLatency::ScopedLatency(LatencyHistogram *histogram):
+    histogram_(histogram) {
+    if (histogram_) {
+        start_ = std::chrono::steady_clock::now();
+    }
+}
+
+inline ScopedLatency::~ScopedLatency() {
+    if (histogram_) {
+        histogram_->record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start_).count());
+    }
+}
+
+#endif  // LATENCY_HISTOGRAM_H_
@@ -9,7 +9,19 @@
 
 #include <iostream>
 #include <vector>
-#include <queue>
+#include <algorithm>
+#include <cstdint>
+
+/**
+ * Number of 64-bit words of a multi-source BFS mask. With AVX2 a batch of
+ * 256 sources fits one vector register, otherwise 64 sources are run at once.
+ */
+#ifdef __AVX2__
+#define MSBFS_WORDS 4
+#else
+#define MSBFS_WORDS 1
+#endif
+#define MSBFS_BATCH (64 * MSBFS_WORDS)
 
 /**
  * Neighbors list implementation.
@@ -17,18 +29,220 @@
 
 template <typename Tinfo>
 class ListGraph {
+ public:
+    /**
+     * One direction of the frozen graph: the neighbors of node i are
+     * targets[offsets[i]] up to targets[offsets[i] + degree[i] - 1], with
+     * their weights at the same positions (nullptr if all weigh 1).
+     */
+    struct CSR {
+        const int *offsets;
+        const int *degree;
+        const int *targets;
+        const int *weights;
+    };
+
+    /**
+     * Scratch buffers of the level-synchronous BFS: the current and the next
+     * frontier, and the frontier as a bitmap for bottom-up steps; on a
+     * weighted graph, the distance buckets of Dial's algorithm. Threads
+     * running BFS at the same time need one each.
+     */
+    struct BFSState {
+        std::vector<int> frontier_;
+        std::vector<int> next_;
+        std::vector<uint64_t> in_frontier_;
+        std::vector<std::vector<int>> buckets_;
+    };
+
+    /**
+     * Scratch buffers of the multi-source BFS: per node, MSBFS_WORDS words
+     * of the sources that have seen it, reached it in the current level and
+     * reach it in the next level; plus the lists of nodes with a non-empty
+     * current / next mask.
+     */
+    struct MSBFSState {
+        std::vector<uint64_t> seen_;
+        std::vector<uint64_t> visit_;
+        std::vector<uint64_t> next_;
+        std::vector<int> active_;
+        std::vector<int> touched_;
+    };
+
  private:
     /**
     * Node structure is useful only for the neighbors list implementation.
     */
     struct Node {
         std::vector<int> neighbors_;
+        std::vector<int> weights_;  // parallel, on weighted graphs only
     };
 
+    /**
+     * Direction switching thresholds of the hybrid BFS: go bottom-up when
+     * the frontier has more than 1/ALPHA of the unexplored edges, go back
+     * top-down when it holds less than 1/BETA of the nodes.
+     */
+    static const int BFS_ALPHA = 14;
+    static const int BFS_BETA = 24;
+
     int size_;
+    long long nr_edges_;
+    unsigned long long epoch_;  // bumped whenever the edge set changes
     std::vector<Node> node_;
     std::vector<Tinfo> node_info_;
 
+    // largest edge weight added since setSize; above 1 the graph is
+    // weighted and every edge keeps its weight, otherwise all weigh 1
+    int max_weight_;
+
+    /**
+     * Compressed sparse row copy of the neighbors lists, built by freeze().
+     * The neighbors of node i are csr_targets_[csr_offsets_[i]] up to
+     * csr_targets_[csr_offsets_[i] + csr_degree_[i] - 1]; the rest of the
+     * row, csr_capacity_[i] slots in all, is free space for edges added
+     * later. A full row is moved to the end of the targets with twice the
+     * room, so rows are not kept in node order and the slots they leave
+     * stay unused until the next full repack.
+     * The rcsr_* arrays hold the reverse graph (in-neighbors) the same way.
+     * The *_weights_ arrays, parallel to the targets, are only filled on a
+     * weighted graph.
+     */
+    bool frozen_;
+    std::vector<int> csr_offsets_;
+    std::vector<int> csr_degree_;
+    std::vector<int> csr_capacity_;
+    std::vector<int> csr_targets_;
+    std::vector<int> rcsr_offsets_;
+    std::vector<int> rcsr_degree_;
+    std::vector<int> rcsr_capacity_;
+    std::vector<int> rcsr_targets_;
+    std::vector<int> csr_weights_;
+    std::vector<int> rcsr_weights_;
+
+    /**
+     * Scratch buffers of the bidirectional BFS. The distance arrays stay
+     * all -1 between searches; only the touched entries get reset.
+     */
+    struct BiBFSState {
+        std::vector<int> dist_fwd_;
+        std::vector<int> dist_bwd_;
+        std::vector<int> front_fwd_;
+        std::vector<int> front_bwd_;
+        std::vector<int> next_;
+        std::vector<int> touched_;
+    };
+
+    BFSState bfs_;
+    BiBFSState bibfs_;
+
+    /**
+     * Packs a CSR from the given lists, leaving one free slot at the end of
+     * every row; capacity gets every row's length, free slot included.
+     */
+    void packCSR(const std::vector<std::vector<int>>& lists,
+                 std::vector<int>& offsets, std::vector<int>& degree,
+                 std::vector<int>& capacity, std::vector<int>& targets);
+
+    /**
+     * Packs the neighbors lists and the in-neighbors lists into the CSR
+     * arrays.
+     */
+    void buildCSR();
+
+    /**
+     * Moves a full CSR row to the end of the targets, with twice its
+     * capacity. Its weights, if the array is not empty, move along.
+     */
+    static void growRow(int node, std::vector<int>& offsets,
+                        const std::vector<int>& degree,
+                        std::vector<int>& capacity, std::vector<int>& targets,
+                        std::vector<int>& weights);
+
+    /**
+     * Removes a value from a CSR row, keeping the order of the others.
+     * The weights of the row, if not nullptr, are moved along.
+     */
+    static void removeFromRow(int *row, int *weights, int& degree, int value);
+
+    // Gives every edge a weight of 1, before the first heavier one is added
+    void makeWeighted();
+
+    /**
+     * Level-synchronous BFS from src. Each level is expanded either
+     * top-down (frontier to neighbors) or, on a frozen graph, bottom-up
+     * (unvisited nodes look for an in-neighbor in the frontier), whichever
+     * has less edges to check.
+     *
+     * @param src Source node.
+     * @param dst Node that stops the search once reached, -1 for none.
+     * @param dist Distances, all -1 on entry; filled for visited nodes.
+     * @param state Scratch buffers.
+     */
+    void hybridBFS(int src, int dst, std::vector<int>& dist,
+                   BFSState& state);
+
+    /**
+     * Shortest distance between two nodes on a frozen graph, growing one
+     * BFS from src over the neighbors and one from dst over the
+     * in-neighbors, a level at a time on the side with the smaller
+     * frontier, until they meet.
+     *
+     * @return distance if there is a path from src to dst, -1 otherwise.
+     */
+    int bidirectionalBFS(int src, int dst);
+
+    /**
+     * Dial's shortest paths on a weighted graph: a circular array of
+     * max_weight_ + 1 buckets, bucket d % (max_weight_ + 1) holding the
+     * nodes at tentative distance d. Distances are settled in increasing
+     * order in O(E + D) for a largest distance D, with no heap.
+     *
+     * @param src Source node.
+     * @param backward Follows the in-neighbors (frozen graph only), so the
+     * distances are to src instead of from it.
+     * @param dist Distances, all -1 on entry; exact for the nodes settled.
+     * @param touched Gets every node whose distance was set.
+     * @param state Scratch buffers.
+     * @param settled Called as settled(nodes, distance) with all the nodes
+     * at each distance, closest first; returning true stops the search.
+     */
+    template <typename Func>
+    void dialSearch(int src, bool backward, std::vector<int>& dist,
+                    std::vector<int>& touched, BFSState& state,
+                    Func settled);
+
+    /**
+     * Expands one level of a bidirectional BFS side.
+     *
+     * @param offsets CSR offsets of the side's direction.
+     * @param degree CSR row lengths of the side's direction.
+     * @param targets CSR targets of the side's direction.
+     * @param front Frontier, replaced by the next level.
+     * @param dist Distances found by this side.
+     * @param other Distances found by the other side.
+     * @param level Distance of the current frontier.
+     * @param best Shortest meeting distance so far, -1 if none.
+     */
+    void expandLevel(const std::vector<int>& offsets,
+                     const std::vector<int>& degree,
+                     const std::vector<int>& targets, std::vector<int>& front,
+                     std::vector<int>& dist, const std::vector<int>& other,
+                     int level, int& best);
+
+    /**
+     * Gets the range of neighbors that BFS routines iterate over: the CSR
+     * row when the graph is frozen, the neighbors list otherwise.
+     *
+     * @param node Node whose neighbors will get returned.
+     * @return pointer to the first neighbor / past the last neighbor.
+     */
+    inline const int *adjBegin(int node);
+    inline const int *adjEnd(int node);
+
+    // Return the weights of the range above; the graph must be weighted
+    inline const int *adjWeights(int node);
+
  public:
     // Constructor
     explicit ListGraph(int size);
@@ -57,23 +271,53 @@ class ListGraph {
      * @param node Node of whose information will be returned.
      * @return information associated to the given node.
      */
-    Tinfo getInfo(int node);
+    const Tinfo& getInfo(int node);
 
     /**
      * Adds an edge between two existing nodes.
      *
      * @param src Source node of the edge to be added.
      * @param dst Destination node of the edge to be added.
+     * @return True if the edge was added, False if it already existed.
      */
-    void addEdge(int src, int dst);
+    bool addEdge(int src, int dst);
+
+    /**
+     * Adds an edge of the given length (segment length, travel time). The
+     * graph becomes weighted once an edge weighs more than 1; until then
+     * no weights are stored.
+     *
+     * @param weight Positive integer weight; Dial's buckets are as many as
+     * the largest weight, so keep it small.
+     * @return True if the edge was added, False if it already existed.
+     */
+    bool addEdge(int src, int dst, int weight);
+
+    /**
+     * Gets the weight of an edge.
+     *
+     * @return weight of the edge from src to dst, -1 if there is none.
+     */
+    int getWeight(int src, int dst);
+
+    /**
+     * Checks if distances are sums of edge weights rather than hop counts.
+     *
+     * @return True if an edge weighing more than 1 was added since setSize.
+     */
+    bool isWeighted();
+
+    // Return the largest edge weight added since setSize, at least 1
+    int getMaxWeight();
 
     /**
      * Removes an existing edge from the graph.
      *
      * @param src Source node of the edge to be removed.
      * @param dst Destination node of the edge to be removed.
+     * @return True if the edge was removed, False if there was none.
      */
-    void removeEdge(int src, int dst);
+    bool removeEdge(int src, int dst);
 
     /**
      * Checks if there is an edge between two existing nodes.
@@ -109,6 +353,25 @@ class ListGraph {
      */
     int neighbor(int node, int index);
 
+    /**
+     * Gets the number of in-neighbors (nodes with an edge to the given node).
+     * The graph must be frozen.
+     *
+     * @param node Node whose number of in-neighbors will get returned.
+     * @return the in-degree of the given node.
+     */
+    int sizeInNeighbors(int node);
+
+    /**
+     * Gets the index-th in-neighbor of the given node. The graph must be
+     * frozen.
+     *
+     * @param node Node whose in-neighbor will get returned.
+     * @param index In-neighbor's index.
+     * @return the index-th in-neighbor of node.
+     */
+    int inNeighbor(int node, int index);
+
     /**
      * Sets the graph new size. Reset edges.
      */
@@ -121,6 +384,65 @@ class ListGraph {
      */
     int getSize();
 
+    /**
+     * Gets the mutation epoch of the graph. It changes every time an edge is
+     * really added or removed, so results tagged with it can be reused
+     * while it stays the same.
+     *
+     * @return the current epoch.
+     */
+    unsigned long long getEpoch();
+
+    /**
+     * Builds the CSR adjacency used by pathFrom, distFrom and getDistNodes,
+     * together with the reverse adjacency needed by bottom-up BFS steps.
+     * Once frozen, addEdge and removeEdge keep the CSR arrays up to date.
+     */
+    void freeze();
+
+    /**
+     * Gets the neighbors lists packed without free space: the neighbors of
+     * node i are targets[offsets[i]] up to targets[offsets[i + 1] - 1], in
+     * the order getNeighbors gives them.
+     *
+     * @param offsets Filled with size + 1 row starts.
+     * @param targets Filled with every edge's destination.
+     * @param weights Filled with every edge's weight, or left empty if the
+     * graph is not weighted.
+     */
+    void exportCSR(std::vector<int>& offsets, std::vector<int>& targets,
+                   std::vector<int>& weights);
+
+    /**
+     * Replaces the graph with the one exportCSR gave, then freezes it.
+     * Node information is reset, as by setSize. The arrays are copied: the
+     * neighbors lists are filled from them and freeze() packs both CSR
+     * directions again, O(V + E) time and memory; nothing points into them
+     * afterwards.
+     *
+     * @param size Number of nodes.
+     * @param offsets size + 1 row starts.
+     * @param targets Destinations of the edges.
+     * @param weights Weights of the edges, nullptr if all weigh 1.
+     */
+    void loadCSR(int size, const int *offsets, const int *targets,
+                 const int *weights);
+
+    /**
+     * Gets the CSR rows of a frozen graph, for the indexes built over it
+     * (ReachIndex, HubLabels). They are valid until the next edge change.
+     *
+     * @param backward Gives the in-neighbors instead of the out-neighbors.
+     */
+    CSR getCSR(bool backward);
+
+    /**
+     * Checks if the BFS routines run on the CSR adjacency.
+     *
+     * @return True if freeze() was called since the last setSize().
+     */
+    bool isFrozen();
+
     /**
      * Checks if there is a path from a given node to another node.
      * 
@@ -131,7 +453,8 @@ class ListGraph {
     bool pathFrom(int src, int dst);
 
     /**
-     * Gets the shortest distance from a given node to another node.
+     * Gets the shortest distance from a given node to another node, the
+     * sum of the edge weights on a weighted graph.
      * 
      * @param src Source node.
      * @param dst Destination node.
@@ -147,11 +470,54 @@ class ListGraph {
      * If there is not a path from the given node to another one, distance = -1.
      */
     std::vector<int> getDistNodes(int node);
+
+    /**
+     * Same as getDistNodes(node), but reuses the caller's buffers. Safe to
+     * call from several threads at once, each with its own state, as long
+     * as nobody changes the graph meanwhile.
+     *
+     * @param node Node from which paths start.
+     * @param dist Filled with the distances of nodes from the given node.
+     * @param state Scratch buffers of the calling thread.
+     */
+    void getDistNodes(int node, std::vector<int>& dist, BFSState& state);
+
+    /**
+     * Runs a BFS from up to MSBFS_BATCH sources at once (MS-BFS): every node
+     * keeps a bitmask of the sources that reached it and a whole level is
+     * expanded with word-wide OR / AND-NOT operations. Thread safety is the
+     * same as for getDistNodes with a state.
+     *
+     * @param sources Source nodes, at most MSBFS_BATCH.
+     * @param nr_sources Number of source nodes.
+     * @param state Scratch buffers of the calling thread.
+     * @param visit Called as visit(k, node, distance) once for every node
+     * reachable from sources[k]; unreachable nodes are not reported.
+     */
+    template <typename Func>
+    void multiSourceDist(const int *sources, int nr_sources,
+                         MSBFSState& state, Func visit);
+
+    /**
+     * Walks the nodes that have a path to dst, closest first: a BFS over
+     * the in-neighbors, one level at a time, or Dial's algorithm over them
+     * on a weighted graph. The graph must be frozen.
+     *
+     * @param dst Node where the paths end.
+     * @param visit Called as visit(nodes, distance) with all the nodes at
+     * the given distance to dst; returning true stops the walk.
+     */
+    template <typename Func>
+    void reverseLevels(int dst, Func visit);
 };
 
 template <typename Tinfo>
 ListGraph<Tinfo>::ListGraph(int size):
-    size_(size), node_(size), node_info_(size) {}
+    size_(size), nr_edges_(0), epoch_(0), node_(size), node_info_(size),
+    max_weight_(1), frozen_(false), csr_offsets_(), csr_degree_(),
+    csr_capacity_(), csr_targets_(), rcsr_offsets_(), rcsr_degree_(),
+    rcsr_capacity_(), rcsr_targets_(), csr_weights_(), rcsr_weights_(),
+    bfs_(), bibfs_() {}
 
 template <typename Tinfo>
 ListGraph<Tinfo>::~ListGraph() {}
@@ -171,31 +537,155 @@ void ListGraph<Tinfo>::addInfo(int node, Tinfo info) {
 }
 
 template <typename Tinfo>
-Tinfo ListGraph<Tinfo>::getInfo(int node) {
+const Tinfo& ListGraph<Tinfo>::getInfo(int node) {
     checkNode(node);
 
     return node_info_[node];
 }
 
 template <typename Tinfo>
-void ListGraph<Tinfo>::addEdge(int src, int dst) {
+bool ListGraph<Tinfo>::addEdge(int src, int dst) {
+    return addEdge(src, dst, 1);
+}
+
+template <typename Tinfo>
+bool ListGraph<Tinfo>::addEdge(int src, int dst, int weight) {
     checkNode(src);
     checkNode(dst);
 
-    if (!hasEdge(src, dst)) {
-        node_[src].neighbors_.push_back(dst);
+    if (hasEdge(src, dst)) {
+        return false;
+    }
+
+    if (weight > max_weight_) {
+        if (max_weight_ == 1) {
+            makeWeighted();
+        }
+        max_weight_ = weight;
+    }
+
+    node_[src].neighbors_.push_back(dst);
+    if (isWeighted()) {
+        node_[src].weights_.push_back(weight);
     }
+    nr_edges_++;
+    epoch_++;
+
+    if (frozen_) {
+        int out, in;
+
+        if (csr_degree_[src] == csr_capacity_[src]) {
+            growRow(src, csr_offsets_, csr_degree_, csr_capacity_,
+                    csr_targets_, csr_weights_);
+        }
+        if (rcsr_degree_[dst] == rcsr_capacity_[dst]) {
+            growRow(dst, rcsr_offsets_, rcsr_degree_, rcsr_capacity_,
+                    rcsr_targets_, rcsr_weights_);
+        }
+
+        out = csr_offsets_[src] + csr_degree_[src];
+        in = rcsr_offsets_[dst] + rcsr_degree_[dst];
+        csr_targets_[out] = dst;
+        rcsr_targets_[in] = src;
+        if (isWeighted()) {
+            csr_weights_[out] = rcsr_weights_[in] = weight;
+        }
+        csr_degree_[src]++;
+        rcsr_degree_[dst]++;
+
+        // repack once moved rows leave more unused slots than edges
+        if (csr_targets_.size() + rcsr_targets_.size() >
+            8ull * (nr_edges_ + size_)) {
+            buildCSR();
+        }
+    }
+
+    return true;
 }
 
 template <typename Tinfo>
-void ListGraph<Tinfo>::removeEdge(int src, int dst) {
+void ListGraph<Tinfo>::makeWeighted() {
+    for (auto it = node_.begin(); it != node_.end(); ++it) {
+        it->weights_.assign(it->neighbors_.size(), 1);
+    }
+
+    if (frozen_) {
+        csr_weights_.assign(csr_targets_.size(), 1);
+        rcsr_weights_.assign(rcsr_targets_.size(), 1);
+    }
+}
+
+template <typename Tinfo>
+int ListGraph<Tinfo>::getWeight(int src, int dst) {
     checkNode(src);
     checkNode(dst);
 
-    for (auto it = node_[src].neighbors_.begin();
-        it != node_[src].neighbors_.end(); ++it) {
-        if (*it == dst) {
-            it = node_[src].neighbors_.erase(it);
+    for (unsigned int i = 0; i < node_[src].neighbors_.size(); ++i) {
+        if (node_[src].neighbors_[i] == dst) {
+            return isWeighted()? node_[src].weights_[i]: 1;
+        }
+    }
+
+    return -1;
+}
+
+template <typename Tinfo>
+bool ListGraph<Tinfo>::isWeighted() {
+    return max_weight_ > 1;
+}
+
+template <typename Tinfo>
+int ListGraph<Tinfo>::getMaxWeight() {
+    return max_weight_;
+}
+
+template <typename Tinfo>
+bool ListGraph<Tinfo>::removeEdge(int src, int dst) {
+    checkNode(src);
+    checkNode(dst);
+
+    std::vector<int>& neighbors = node_[src].neighbors_;
+
+    for (unsigned int i = 0; i < neighbors.size(); ++i) {
+        if (neighbors[i] == dst) {
+            neighbors.erase(neighbors.begin() + i);
+            if (isWeighted()) {
+                node_[src].weights_.erase(node_[src].weights_.begin() + i);
+            }
+            nr_edges_--;
+            epoch_++;
+
+            if (frozen_) {
+                removeFromRow(&csr_targets_[csr_offsets_[src]],
+                              isWeighted()? &csr_weights_[csr_offsets_[src]]:
+                                            nullptr,
+                              csr_degree_[src], dst);
+                removeFromRow(&rcsr_targets_[rcsr_offsets_[dst]],
+                              isWeighted()? &rcsr_weights_[rcsr_offsets_[dst]]:
+                                            nullptr,
+                              rcsr_degree_[dst], src);
+            }
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+template <typename Tinfo>
+void ListGraph<Tinfo>::removeFromRow(int *row, int *weights, int& degree,
+                                     int value) {
+    for (int i = 0; i < degree; ++i) {
+        if (row[i] == value) {
+            // shift left to keep the same order as the neighbors list
+            for (int j = i + 1; j < degree; ++j) {
+                row[j - 1] = row[j];
+                if (weights) {
+                    weights[j - 1] = weights[j];
+                }
+            }
+            degree--;
             break;
         }
     }
@@ -237,11 +727,40 @@ int ListGraph<Tinfo>::neighbor(int node, int index) {
     return node_[node].neighbors_[index];
 }
 
+template <typename Tinfo>
+int ListGraph<Tinfo>::sizeInNeighbors(int node) {
+    checkNode(node);
+
+    return rcsr_degree_[node];
+}
+
+template <typename Tinfo>
+int ListGraph<Tinfo>::inNeighbor(int node, int index) {
+    checkNode(node);
+
+    return rcsr_targets_[rcsr_offsets_[node] + index];
+}
+
 template <typename Tinfo>
 void ListGraph<Tinfo>::setSize(int size) {
     size_ = size;
+    nr_edges_ = 0;
+    epoch_++;
     node_ = std::vector<Node>(size);
     node_info_ = std::vector<Tinfo>(size);
+    max_weight_ = 1;
+
+    frozen_ = false;
+    csr_offsets_.clear();
+    csr_degree_.clear();
+    csr_capacity_.clear();
+    csr_targets_.clear();
+    rcsr_offsets_.clear();
+    rcsr_degree_.clear();
+    rcsr_capacity_.clear();
+    rcsr_targets_.clear();
+    csr_weights_.clear();
+    rcsr_weights_.clear();
 }
 
 template <typename Tinfo>
@@ -250,65 +769,480 @@ int ListGraph<Tinfo>::getSize() {
 }
 
 template <typename Tinfo>
-bool ListGraph<Tinfo>::pathFrom(int src, int dst) {
-    checkNode(src);
-    checkNode(dst);
+unsigned long long ListGraph<Tinfo>::getEpoch() {
+    return epoch_;
+}
+
+template <typename Tinfo>
+void ListGraph<Tinfo>::packCSR(const std::vector<std::vector<int>>& lists,
+                               std::vector<int>& offsets,
+                               std::vector<int>& degree,
+                               std::vector<int>& capacity,
+                               std::vector<int>& targets) {
+    int i, total = 0;
+
+    offsets.assign(size_ + 1, 0);
+    degree.assign(size_, 0);
+    capacity.assign(size_, 0);
+
+    for (i = 0; i < size_; ++i) {
+        offsets[i] = total;
+        degree[i] = lists[i].size();
+        capacity[i] = degree[i] + 1;
+        total += capacity[i];
+    }
+    offsets[size_] = total;
+
+    targets.assign(total, -1);
+    for (i = 0; i < size_; ++i) {
+        std::copy(lists[i].begin(), lists[i].end(),
+                  targets.begin() + offsets[i]);
+    }
+}
 
-    std::vector<bool> visited(size_, false);
-    std::queue<int> q;
-    int node;
+template <typename Tinfo>
+void ListGraph<Tinfo>::buildCSR() {
+    std::vector<std::vector<int>> out(size_), in(size_);
+    std::vector<std::vector<int>> out_weights, in_weights;
+    std::vector<int> offsets, degree, capacity;
 
-    visited[src] = true;
-    q.push(src);
+    for (int i = 0; i < size_; ++i) {
+        out[i] = node_[i].neighbors_;
 
-    while (!q.empty()) {
-        node = q.front();
-        q.pop();
+        for (auto it = node_[i].neighbors_.begin();
+            it != node_[i].neighbors_.end(); ++it) {
+            in[*it].push_back(i);
+        }
+    }
 
-        if (node == dst) {
-            return true;
+    packCSR(out, csr_offsets_, csr_degree_, csr_capacity_, csr_targets_);
+    packCSR(in, rcsr_offsets_, rcsr_degree_, rcsr_capacity_, rcsr_targets_);
+
+    if (!isWeighted()) {
+        csr_weights_.clear();
+        rcsr_weights_.clear();
+        return;
+    }
+
+    // the weights go in the same slots as their targets
+    out_weights.resize(size_);
+    in_weights.resize(size_);
+    for (int i = 0; i < size_; ++i) {
+        out_weights[i] = node_[i].weights_;
+
+        for (unsigned int j = 0; j < node_[i].neighbors_.size(); ++j) {
+            in_weights[node_[i].neighbors_[j]].push_back(
+                node_[i].weights_[j]);
         }
+    }
+
+    packCSR(out_weights, offsets, degree, capacity, csr_weights_);
+    packCSR(in_weights, offsets, degree, capacity, rcsr_weights_);
+}
+
+template <typename Tinfo>
+void ListGraph<Tinfo>::growRow(int node, std::vector<int>& offsets,
+                               const std::vector<int>& degree,
+                               std::vector<int>& capacity,
+                               std::vector<int>& targets,
+                               std::vector<int>& weights) {
+    int from = offsets[node], to = targets.size();
+
+    capacity[node] *= 2;
+    targets.resize(to + capacity[node], -1);
+    std::copy(targets.begin() + from, targets.begin() + from + degree[node],
+              targets.begin() + to);
+
+    if (!weights.empty()) {
+        weights.resize(to + capacity[node], 1);
+        std::copy(weights.begin() + from,
+                  weights.begin() + from + degree[node], weights.begin() + to);
+    }
+
+    offsets[node] = to;
+}
 
-        for (auto it = node_[node].neighbors_.begin();
-            it != node_[node].neighbors_.end(); ++it) {
-            if (!visited[*it]) {
-                visited[*it] = true;
-                q.push(*it);
+template <typename Tinfo>
+inline const int *ListGraph<Tinfo>::adjBegin(int node) {
+    if (frozen_) {
+        return csr_targets_.data() + csr_offsets_[node];
+    }
+
+    return node_[node].neighbors_.data();
+}
+
+template <typename Tinfo>
+inline const int *ListGraph<Tinfo>::adjEnd(int node) {
+    if (frozen_) {
+        return csr_targets_.data() + csr_offsets_[node] + csr_degree_[node];
+    }
+
+    return node_[node].neighbors_.data() + node_[node].neighbors_.size();
+}
+
+template <typename Tinfo>
+inline const int *ListGraph<Tinfo>::adjWeights(int node) {
+    if (frozen_) {
+        return csr_weights_.data() + csr_offsets_[node];
+    }
+
+    return node_[node].weights_.data();
+}
+
+template <typename Tinfo>
+void ListGraph<Tinfo>::freeze() {
+    buildCSR();
+    frozen_ = true;
+}
+
+template <typename Tinfo>
+void ListGraph<Tinfo>::exportCSR(std::vector<int>& offsets,
+                                 std::vector<int>& targets,
+                                 std::vector<int>& weights) {
+    offsets.assign(size_ + 1, 0);
+    targets.clear();
+    targets.reserve(nr_edges_);
+    weights.clear();
+
+    for (int i = 0; i < size_; ++i) {
+        offsets[i] = targets.size();
+        targets.insert(targets.end(), node_[i].neighbors_.begin(),
+                       node_[i].neighbors_.end());
+        weights.insert(weights.end(), node_[i].weights_.begin(),
+                       node_[i].weights_.end());
+    }
+    offsets[size_] = targets.size();
+}
+
+template <typename Tinfo>
+void ListGraph<Tinfo>::loadCSR(int size, const int *offsets,
+                               const int *targets, const int *weights) {
+    setSize(size);
+
+    for (int i = 0; i < size_; ++i) {
+        node_[i].neighbors_.assign(targets + offsets[i],
+                                   targets + offsets[i + 1]);
+
+        if (weights) {
+            node_[i].weights_.assign(weights + offsets[i],
+                                     weights + offsets[i + 1]);
+            for (int j = offsets[i]; j < offsets[i + 1]; ++j) {
+                max_weight_ = std::max(max_weight_, weights[j]);
             }
         }
     }
+    nr_edges_ = offsets[size_];
 
-    return false;
+    // weights that are all 1 are not kept, as by addEdge
+    if (!isWeighted()) {
+        for (int i = 0; i < size_; ++i) {
+            node_[i].weights_.clear();
+        }
+    }
+
+    freeze();
 }
 
 template <typename Tinfo>
-int ListGraph<Tinfo>::distFrom(int src, int dst) {
+typename ListGraph<Tinfo>::CSR ListGraph<Tinfo>::getCSR(bool backward) {
+    if (backward) {
+        return CSR{rcsr_offsets_.data(), rcsr_degree_.data(),
+                   rcsr_targets_.data(),
+                   isWeighted()? rcsr_weights_.data(): nullptr};
+    }
+
+    return CSR{csr_offsets_.data(), csr_degree_.data(), csr_targets_.data(),
+               isWeighted()? csr_weights_.data(): nullptr};
+}
+
+template <typename Tinfo>
+bool ListGraph<Tinfo>::isFrozen() {
+    return frozen_;
+}
+
+template <typename Tinfo>
+void ListGraph<Tinfo>::hybridBFS(int src, int dst, std::vector<int>& dist,
+                                 BFSState& state) {
+    std::vector<int>& frontier = state.frontier_;
+    std::vector<int>& next = state.next_;
+    long long edges_frontier, edges_unexplored = 0;
+    bool bottom_up = false;
+    int level = 0;
+
+    frontier.clear();
+    frontier.push_back(src);
+    dist[src] = 0;
+
+    if (frozen_) {
+        edges_unexplored = nr_edges_ - rcsr_degree_[src];
+    }
+
+    while (!frontier.empty() && (dst == -1 || dist[dst] == -1)) {
+        if (frozen_) {
+            if (!bottom_up) {
+                edges_frontier = 0;
+                for (auto it = frontier.begin(); it != frontier.end(); ++it) {
+                    edges_frontier += csr_degree_[*it];
+                }
+
+                bottom_up = edges_frontier > edges_unexplored / BFS_ALPHA;
+            } else {
+                bottom_up = (long long)frontier.size() * BFS_BETA >= size_;
+            }
+        }
+
+        next.clear();
+
+        if (!bottom_up) {
+            for (auto node = frontier.begin(); node != frontier.end(); ++node) {
+                for (const int *it = adjBegin(*node), *end = adjEnd(*node);
+                    it != end; ++it) {
+                    if (dist[*it] == -1) {
+                        dist[*it] = level + 1;
+                        next.push_back(*it);
+
+                        if (frozen_) {
+                            edges_unexplored -= rcsr_degree_[*it];
+                        }
+                    }
+                }
+            }
+        } else {
+            std::vector<uint64_t>& in_frontier = state.in_frontier_;
+
+            in_frontier.assign((size_ + 63) / 64, 0);
+            for (auto it = frontier.begin(); it != frontier.end(); ++it) {
+                in_frontier[*it >> 6] |= 1ULL << (*it & 63);
+            }
+
+            for (int node = 0; node < size_; ++node) {
+                if (dist[node] != -1) {
+                    continue;
+                }
+
+                const int *it = rcsr_targets_.data() + rcsr_offsets_[node];
+                const int *end = it + rcsr_degree_[node];
+
+                for (; it != end; ++it) {
+                    if (in_frontier[*it >> 6] >> (*it & 63) & 1) {
+                        dist[node] = level + 1;
+                        next.push_back(node);
+                        edges_unexplored -= rcsr_degree_[node];
+                        break;
+                    }
+                }
+            }
+        }
+
+        frontier.swap(next);
+        level++;
+    }
+}
+
+template <typename Tinfo>
+void ListGraph<Tinfo>::expandLevel(const std::vector<int>& offsets,
+                                   const std::vector<int>& degree,
+                                   const std::vector<int>& targets,
+                                   std::vector<int>& front,
+                                   std::vector<int>& dist,
+                                   const std::vector<int>& other,
+                                   int level, int& best) {
+    std::vector<int>& next = bibfs_.next_;
+
+    next.clear();
+
+    for (auto node = front.begin(); node != front.end(); ++node) {
+        const int *it = targets.data() + offsets[*node];
+        const int *end = it + degree[*node];
+
+        for (; it != end; ++it) {
+            if (dist[*it] != -1) {
+                continue;
+            }
+
+            dist[*it] = level + 1;
+            next.push_back(*it);
+            bibfs_.touched_.push_back(*it);
+
+            if (other[*it] != -1 &&
+                (best == -1 || level + 1 + other[*it] < best)) {
+                best = level + 1 + other[*it];
+            }
+        }
+    }
+
+    front.swap(next);
+}
+
+template <typename Tinfo>
+int ListGraph<Tinfo>::bidirectionalBFS(int src, int dst) {
+    BiBFSState& st = bibfs_;
+    int best = -1, level_fwd = 0, level_bwd = 0;
+
+    if (src == dst) {
+        return 0;
+    }
+
+    if ((int)st.dist_fwd_.size() != size_) {
+        st.dist_fwd_.assign(size_, -1);
+        st.dist_bwd_.assign(size_, -1);
+    }
+
+    st.front_fwd_.assign(1, src);
+    st.front_bwd_.assign(1, dst);
+    st.touched_.clear();
+    st.touched_.push_back(src);
+    st.touched_.push_back(dst);
+    st.dist_fwd_[src] = 0;
+    st.dist_bwd_[dst] = 0;
+
+    // Any path not seen yet is longer than level_fwd + level_bwd, so the
+    // best meeting found is final once it is not longer than that.
+    while (!st.front_fwd_.empty() && !st.front_bwd_.empty() &&
+           (best == -1 || best > level_fwd + level_bwd)) {
+        if (st.front_fwd_.size() <= st.front_bwd_.size()) {
+            expandLevel(csr_offsets_, csr_degree_, csr_targets_,
+                        st.front_fwd_, st.dist_fwd_, st.dist_bwd_,
+                        level_fwd++, best);
+        } else {
+            expandLevel(rcsr_offsets_, rcsr_degree_, rcsr_targets_,
+                        st.front_bwd_, st.dist_bwd_, st.dist_fwd_,
+                        level_bwd++, best);
+        }
+    }
+
+    for (auto it = st.touched_.begin(); it != st.touched_.end(); ++it) {
+        st.dist_fwd_[*it] = -1;
+        st.dist_bwd_[*it] = -1;
+    }
+
+    return best;
+}
+
+template <typename Tinfo>
+bool ListGraph<Tinfo>::pathFrom(int src, int dst) {
     checkNode(src);
     checkNode(dst);
 
+    if (frozen_) {
+        return bidirectionalBFS(src, dst) != -1;
+    }
+
     std::vector<int> dist(size_, -1);
-    std::queue<int> q;
-    int node;
+
+    hybridBFS(src, dst, dist, bfs_);
+
+    return dist[dst] != -1;
+}
+
+template <typename Tinfo>
+template <typename Func>
+void ListGraph<Tinfo>::dialSearch(int src, bool backward,
+                                  std::vector<int>& dist,
+                                  std::vector<int>& touched,
+                                  BFSState& state, Func settled) {
+    std::vector<std::vector<int>>& buckets = state.buckets_;
+    std::vector<int>& nodes = state.frontier_;
+    const int *it, *end, *weight;
+    long long pending = 1;
+    int nr_buckets = max_weight_ + 1, next;
+
+    // a weight is below nr_buckets, so pending distances never wrap onto
+    // the bucket being settled
+    buckets.resize(nr_buckets);
+    for (auto bucket = buckets.begin(); bucket != buckets.end(); ++bucket) {
+        bucket->clear();
+    }
 
     dist[src] = 0;
-    q.push(src);
+    touched.push_back(src);
+    buckets[0].push_back(src);
 
-    while (!q.empty()) {
-        node = q.front();
-        q.pop();
+    for (int d = 0; pending; ++d) {
+        std::vector<int>& bucket = buckets[d % nr_buckets];
 
-        if (node == dst) {
-            break;
+        // entries left behind by a later decrease are skipped
+        nodes.clear();
+        for (auto node = bucket.begin(); node != bucket.end(); ++node) {
+            if (dist[*node] == d) {
+                nodes.push_back(*node);
+            }
+        }
+        pending -= bucket.size();
+        bucket.clear();
+
+        if (nodes.empty()) {
+            continue;
+        }
+
+        if (settled(nodes, d)) {
+            return;
         }
 
-        for (auto it = node_[node].neighbors_.begin();
-            it != node_[node].neighbors_.end(); ++it) {
-            if (dist[*it] == -1) {
-                dist[*it] = dist[node] + 1;
-                q.push(*it);
+        for (auto node = nodes.begin(); node != nodes.end(); ++node) {
+            if (backward) {
+                it = rcsr_targets_.data() + rcsr_offsets_[*node];
+                end = it + rcsr_degree_[*node];
+                weight = rcsr_weights_.data() + rcsr_offsets_[*node];
+            } else {
+                it = adjBegin(*node);
+                end = adjEnd(*node);
+                weight = adjWeights(*node);
+            }
+
+            for (; it != end; ++it, ++weight) {
+                next = d + *weight;
+
+                if (dist[*it] == -1 || next < dist[*it]) {
+                    if (dist[*it] == -1) {
+                        touched.push_back(*it);
+                    }
+
+                    dist[*it] = next;
+                    buckets[next % nr_buckets].push_back(*it);
+                    pending++;
+                }
             }
         }
     }
+}
+
+template <typename Tinfo>
+int ListGraph<Tinfo>::distFrom(int src, int dst) {
+    checkNode(src);
+    checkNode(dst);
+
+    if (isWeighted()) {
+        std::vector<int>& dist = bibfs_.dist_fwd_;
+        int found;
+
+        if ((int)dist.size() != size_) {
+            dist.assign(size_, -1);
+            bibfs_.dist_bwd_.assign(size_, -1);
+        }
+
+        bibfs_.touched_.clear();
+        dialSearch(src, false, dist, bibfs_.touched_, bfs_,
+                   [&](const std::vector<int>&, int d) {
+                       return dist[dst] != -1 && dist[dst] <= d;
+                   });
+
+        found = dist[dst];
+        for (auto it = bibfs_.touched_.begin(); it != bibfs_.touched_.end();
+            ++it) {
+            dist[*it] = -1;
+        }
+
+        return found;
+    }
+
+    if (frozen_) {
+        return bidirectionalBFS(src, dst);
+    }
+
+    std::vector<int> dist(size_, -1);
+
+    hybridBFS(src, dst, dist, bfs_);
 
     return dist[dst];
 }
@@ -317,26 +1251,179 @@ template <typename Tinfo>
 std::vector<int> ListGraph<Tinfo>::getDistNodes(int node) {
     checkNode(node);
 
-    std::vector<int> dist(size_, -1);
-    std::queue<int> q;
+    std::vector<int> dist;
 
-    dist[node] = 0;
-    q.push(node);
+    getDistNodes(node, dist, bfs_);
 
-    while (!q.empty()) {
-        node = q.front();
-        q.pop();
+    return dist;
+}
 
-        for (auto it = node_[node].neighbors_.begin();
-            it != node_[node].neighbors_.end(); ++it) {
-            if (dist[*it] == -1) {
-                dist[*it] = dist[node] + 1;
-                q.push(*it);
+template <typename Tinfo>
+void ListGraph<Tinfo>::getDistNodes(int node, std::vector<int>& dist,
+                                    BFSState& state) {
+    checkNode(node);
+
+    dist.assign(size_, -1);
+
+    if (isWeighted()) {
+        state.next_.clear();
+        dialSearch(node, false, dist, state.next_, state,
+                   [](const std::vector<int>&, int) { return false; });
+        return;
+    }
+
+    hybridBFS(node, -1, dist, state);
+}
+
+template <typename Tinfo>
+template <typename Func>
+void ListGraph<Tinfo>::multiSourceDist(const int *sources, int nr_sources,
+                                       MSBFSState& state, Func visit) {
+    std::vector<uint64_t>& seen = state.seen_;
+    std::vector<uint64_t>& cur = state.visit_;
+    std::vector<uint64_t>& next = state.next_;
+    std::vector<int>& active = state.active_;
+    std::vector<int>& touched = state.touched_;
+    uint64_t bits[MSBFS_WORDS], any;
+    int k, w, level = 0;
+
+    seen.assign((size_t)size_ * MSBFS_WORDS, 0);
+    cur.assign((size_t)size_ * MSBFS_WORDS, 0);
+    next.assign((size_t)size_ * MSBFS_WORDS, 0);
+    active.clear();
+
+    for (k = 0; k < nr_sources; ++k) {
+        checkNode(sources[k]);
+
+        uint64_t *mask = &cur[(size_t)sources[k] * MSBFS_WORDS];
+
+        // a node given twice as source is still expanded once per level
+        for (any = 0, w = 0; w < MSBFS_WORDS; ++w) {
+            any |= mask[w];
+        }
+        if (!any) {
+            active.push_back(sources[k]);
+        }
+
+        mask[k >> 6] |= 1ULL << (k & 63);
+        seen[(size_t)sources[k] * MSBFS_WORDS + (k >> 6)] |= 1ULL << (k & 63);
+        visit(k, sources[k], 0);
+    }
+
+    while (!active.empty()) {
+        touched.clear();
+        level++;
+
+        // push the sources of every active node to its neighbors
+        for (auto node = active.begin(); node != active.end(); ++node) {
+            const uint64_t *from = &cur[(size_t)*node * MSBFS_WORDS];
+
+            for (const int *it = adjBegin(*node), *end = adjEnd(*node);
+                it != end; ++it) {
+                uint64_t *to = &next[(size_t)*it * MSBFS_WORDS];
+
+                for (any = 0, w = 0; w < MSBFS_WORDS; ++w) {
+                    any |= to[w];
+                }
+                if (!any) {
+                    touched.push_back(*it);
+                }
+
+                for (w = 0; w < MSBFS_WORDS; ++w) {
+                    to[w] |= from[w];
+                }
+            }
+        }
+
+        for (auto node = active.begin(); node != active.end(); ++node) {
+            for (w = 0; w < MSBFS_WORDS; ++w) {
+                cur[(size_t)*node * MSBFS_WORDS + w] = 0;
+            }
+        }
+        active.clear();
+
+        // keep only the sources that reach a node for the first time
+        for (auto node = touched.begin(); node != touched.end(); ++node) {
+            uint64_t *to = &next[(size_t)*node * MSBFS_WORDS];
+            uint64_t *was = &seen[(size_t)*node * MSBFS_WORDS];
+            uint64_t *now = &cur[(size_t)*node * MSBFS_WORDS];
+
+            for (any = 0, w = 0; w < MSBFS_WORDS; ++w) {
+                bits[w] = to[w] & ~was[w];
+                was[w] |= bits[w];
+                now[w] = bits[w];
+                to[w] = 0;
+                any |= bits[w];
+            }
+
+            if (!any) {
+                continue;
+            }
+
+            active.push_back(*node);
+            for (w = 0; w < MSBFS_WORDS; ++w) {
+                while (bits[w]) {
+                    visit(w * 64 + __builtin_ctzll(bits[w]), *node, level);
+                    bits[w] &= bits[w] - 1;
+                }
             }
         }
     }
+}
 
-    return dist;
+template <typename Tinfo>
+template <typename Func>
+void ListGraph<Tinfo>::reverseLevels(int dst, Func visit) {
+    checkNode(dst);
+
+    // the backward half of the bidirectional BFS scratch is free here
+    BiBFSState& st = bibfs_;
+    std::vector<int>& dist = st.dist_bwd_;
+    int level = 0;
+
+    if ((int)dist.size() != size_) {
+        st.dist_fwd_.assign(size_, -1);
+        dist.assign(size_, -1);
+    }
+
+    if (isWeighted()) {
+        st.touched_.clear();
+        dialSearch(dst, true, dist, st.touched_, bfs_, visit);
+
+        for (auto it = st.touched_.begin(); it != st.touched_.end(); ++it) {
+            dist[*it] = -1;
+        }
+        return;
+    }
+
+    st.front_bwd_.assign(1, dst);
+    st.touched_.assign(1, dst);
+    dist[dst] = 0;
+
+    while (!st.front_bwd_.empty() && !visit(st.front_bwd_, level)) {
+        st.next_.clear();
+
+        for (auto node = st.front_bwd_.begin(); node != st.front_bwd_.end();
+            ++node) {
+            const int *it = rcsr_targets_.data() + rcsr_offsets_[*node];
+            const int *end = it + rcsr_degree_[*node];
+
+            for (; it != end; ++it) {
+                if (dist[*it] == -1) {
+                    dist[*it] = level + 1;
+                    st.next_.push_back(*it);
+                    st.touched_.push_back(*it);
+                }
+            }
+        }
+
+        st.front_bwd_.swap(st.next_);
+        level++;
+    }
+
+    for (auto it = st.touched_.begin(); it != st.touched_.end(); ++it) {
+        dist[*it] = -1;
+    }
 }
 
 #endif  // LIST_GRAPH_H_
@@ -0,0 +1,56 @@
+// Copyright 2019 Nedelcu Horia (nedelcu.horia.alexandru@gmail.com)
+
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include "./name_pool.h"
+
+NamePool::NamePool(): chunks_(), names_(), current_(nullptr),
+    used_(NAME_POOL_CHUNK), bytes_(0) {}
+
+NamePool::~NamePool() {}
+
+void NamePool::clear() {
+    chunks_.clear();
+    names_.clear();
+    current_ = nullptr;
+    used_ = NAME_POOL_CHUNK;
+    bytes_ = 0;
+}
+
+int NamePool::add(std::string_view name) {
+    char *bytes;
+
+    if (name.size() > NAME_POOL_CHUNK) {
+        chunks_.emplace_back(new char[name.size()]);
+        bytes_ += name.size();
+        bytes = chunks_.back().get();
+    } else {
+        if (used_ + name.size() > NAME_POOL_CHUNK) {
+            chunks_.emplace_back(new char[NAME_POOL_CHUNK]);
+            bytes_ += NAME_POOL_CHUNK;
+            current_ = chunks_.back().get();
+            used_ = 0;
+        }
+
+        bytes = current_ + used_;
+        used_ += name.size();
+    }
+
+    std::memcpy(bytes, name.data(), name.size());
+    names_.push_back(std::string_view(bytes, name.size()));
+    return names_.size() - 1;
+}
+
+std::string_view NamePool::name(int id) const {
+    return names_[id];
+}
+
+int NamePool::getSize() const {
+    return names_.size();
+}
+
+size_t NamePool::getBytes() const {
+    return bytes_;
+}
@@ -0,0 +1,59 @@
+// Copyright 2019 Nedelcu Horia (nedelcu.horia.alexandru@gmail.com)
+
+/**
+ * name_pool.h
+ */
+
+#ifndef NAME_POOL_H_
+#define NAME_POOL_H_
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// bytes of one arena chunk; longer names get a chunk of their own
+#define NAME_POOL_CHUNK (64 << 10)
+
+/**
+ * Arena holding every intersection and driver name once. A name is copied
+ * into a chunk and gets a 32-bit id; chunks are never moved or freed, so
+ * the std::string_view of a name stays valid as long as the pool, and the
+ * other structures keep ids or views instead of their own copies.
+ */
+class NamePool {
+ private:
+    std::vector<std::unique_ptr<char[]>> chunks_;
+    std::vector<std::string_view> names_;  // id -> name
+    char *current_;                        // chunk being filled
+    size_t used_;                          // bytes used in current_
+    size_t bytes_;
+
+ public:
+    // Constructor
+    NamePool();
+
+    // Destructor
+    ~NamePool();
+
+    // Drops every name; views given out before are no longer valid
+    void clear();
+
+    /**
+     * Copies a name into the arena.
+     *
+     * @return id of the name, the number of names added before it.
+     */
+    int add(std::string_view name);
+
+    // Return the name with the given id, stored in the arena
+    std::string_view name(int id) const;
+
+    // Return number of names
+    int getSize() const;
+
+    // Return bytes of the chunks allocated
+    size_t getBytes() const;
+};
+
+#endif  // NAME_POOL_H_
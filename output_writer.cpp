@@ -0,0 +1,100 @@
+// Copyright 2019 Nedelcu Horia (nedelcu.horia.alexandru@gmail.com)
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <cerrno>
+#include <charconv>
+#include <ostream>
+#include <string_view>
+#include <vector>
+#include "./output_writer.h"
+#include "./stream_fd.h"
+
+OutputWriter::OutputWriter(const char *path):
+    fd_(open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644)), stream_(nullptr),
+    buffer_(OUTPUT_WRITER_BUFFER), used_(0) {}
+
+OutputWriter::OutputWriter(std::ostream& stream): fd_(streamFd(stream)),
+    stream_(&stream), buffer_(OUTPUT_WRITER_BUFFER), used_(0) {
+    // what the stream holds goes to the file before anything written here
+    stream.flush();
+}
+
+OutputWriter::~OutputWriter() {
+    close();
+}
+
+bool OutputWriter::isOpen() const {
+    return fd_ != -1 || stream_;
+}
+
+void OutputWriter::flushWith(const char *text, size_t size) {
+    struct iovec parts[2];
+    ssize_t count;
+    int first = 0;
+
+    parts[0].iov_base = buffer_.data();
+    parts[0].iov_len = used_;
+    parts[1].iov_base = const_cast<char *>(text);
+    parts[1].iov_len = size;
+    used_ = 0;
+
+    if (fd_ == -1) {
+        if (stream_) {
+            stream_->write(static_cast<char *>(parts[0].iov_base),
+                           parts[0].iov_len);
+            stream_->write(text, size);
+        }
+        return;
+    }
+
+    // writev may write only a part; go on from where it stopped
+    while (first < 2) {
+        count = writev(fd_, parts + first, 2 - first);
+
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+
+        for (; first < 2 && (size_t)count >= parts[first].iov_len; ++first) {
+            count -= parts[first].iov_len;
+        }
+
+        if (first < 2) {
+            parts[first].iov_base =
+                static_cast<char *>(parts[first].iov_base) + count;
+            parts[first].iov_len -= count;
+        }
+    }
+}
+
+void OutputWriter::flush() {
+    flushWith(nullptr, 0);
+}
+
+void OutputWriter::close() {
+    flush();
+
+    // a stream's descriptor is closed by the stream
+    if (stream_) {
+        stream_->flush();
+        stream_ = nullptr;
+    } else if (fd_ != -1) {
+        ::close(fd_);
+    }
+    fd_ = -1;
+}
+
+OutputWriter& OutputWriter::operator<<(const Fixed& value) {
+    // a double in fixed notation fits in 310 digits plus the precision
+    char *first = reserve(330 + value.precision);
+
+    used_ = std::to_chars(first, buffer_.data() + buffer_.size(), value.value,
+                          std::chars_format::fixed,
+                          value.precision).ptr - buffer_.data();
+    return *this;
+}
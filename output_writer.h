@@ -0,0 +1,118 @@
+// Copyright 2019 Nedelcu Horia (nedelcu.horia.alexandru@gmail.com)
+
+/**
+ * output_writer.h
+ */
+
+#ifndef OUTPUT_WRITER_H_
+#define OUTPUT_WRITER_H_
+
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+// bytes gathered before they are written to the file
+#define OUTPUT_WRITER_BUFFER (1 << 20)
+
+// A double to be written in fixed notation, like std::fixed with
+// std::setprecision(precision) would
+struct Fixed {
+    double value;
+    int precision;
+};
+
+/**
+ * Output file written through one large reusable buffer. Numbers are
+ * formatted with std::to_chars straight into the buffer; the buffer goes
+ * to the file with one write() when full, and text too long to fit is
+ * written together with it by one writev(). A writer may also go to a
+ * stream opened elsewhere: a std::ofstream is written the same way,
+ * through its file descriptor, and any other stream gets the buffer with
+ * one write() call on it.
+ */
+class OutputWriter {
+ private:
+    int fd_;                // -1 if the stream has no file under it
+    std::ostream *stream_;  // owner of fd_, or written to if fd_ is -1
+    std::vector<char> buffer_;
+    size_t used_;
+
+    // Writes the buffer, then text, to the file; empties the buffer
+    void flushWith(const char *text, size_t size);
+
+    // Makes room for at least size more bytes in the buffer
+    inline char *reserve(size_t size);
+
+ public:
+    // Constructor; creates or truncates the file
+    explicit OutputWriter(const char *path);
+
+    // Constructor; writes to the stream, which stays open after close()
+    explicit OutputWriter(std::ostream& stream);
+
+    // Destructor; flushes and closes the file
+    ~OutputWriter();
+
+    OutputWriter(const OutputWriter&) = delete;
+    OutputWriter& operator=(const OutputWriter&) = delete;
+
+    // Return true if the file could be opened
+    bool isOpen() const;
+
+    // Writes everything buffered to the file
+    void flush();
+
+    // Flushes and closes the file, or flushes the stream
+    void close();
+
+    inline OutputWriter& operator<<(char value);
+
+    inline OutputWriter& operator<<(std::string_view value);
+
+    inline OutputWriter& operator<<(const char *value);
+
+    inline OutputWriter& operator<<(int value);
+
+    OutputWriter& operator<<(const Fixed& value);
+};
+
+inline char *OutputWriter::reserve(size_t size) {
+    if (used_ + size > buffer_.size()) {
+        flush();
+    }
+
+    return buffer_.data() + used_;
+}
+
+inline OutputWriter& OutputWriter::operator<<(char value) {
+    *reserve(1) = value;
+    used_++;
+    return *this;
+}
+
+inline OutputWriter& OutputWriter::operator<<(std::string_view value) {
+    if (used_ + value.size() > buffer_.size()) {
+        flushWith(value.data(), value.size());
+    } else {
+        std::memcpy(buffer_.data() + used_, value.data(), value.size());
+        used_ += value.size();
+    }
+
+    return *this;
+}
+
+inline OutputWriter& OutputWriter::operator<<(const char *value) {
+    return *this << std::string_view(value);
+}
+
+inline OutputWriter& OutputWriter::operator<<(int value) {
+    char *first = reserve(16);
+
+    used_ = std::to_chars(first, first + 16, value).ptr - buffer_.data();
+    return *this;
+}
+
+#endif  // OUTPUT_WRITER_H_
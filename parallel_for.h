@@ -0,0 +1,61 @@
+// Copyright 2019 Nedelcu Horia (nedelcu.horia.alexandru@gmail.com)
+
+/**
+ * parallel_for.h
+ */
+
+#ifndef PARALLEL_FOR_H_
+#define PARALLEL_FOR_H_
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/**
+ * Runs func(worker, index) for every index in [begin, end) on a pool of
+ * worker threads. Indexes are handed out in chunks from a shared counter,
+ * so workers that got cheap indexes come back for more (dynamic scheduling).
+ * The worker id is in [0, nr_threads) and lets func keep per-thread state.
+ * No more workers are started than there are chunks, so a range of a single
+ * chunk runs on the caller without starting any thread.
+ *
+ * @param begin First index.
+ * @param end One past the last index.
+ * @param chunk Number of indexes a worker takes at once.
+ * @param nr_threads Number of workers; 1 runs everything on the caller.
+ * @param func Work to be done for one index.
+ */
+template <typename Func>
+void parallel_for(int begin, int end, int chunk, int nr_threads, Func func) {
+    std::atomic<int> next(begin);
+    std::vector<std::thread> workers;
+
+    chunk = std::max(chunk, 1);
+    nr_threads = std::max(std::min(nr_threads,
+                                   (end - begin + chunk - 1) / chunk), 1);
+
+    auto work = [&](int worker) {
+        int first, last;
+
+        while ((first = next.fetch_add(chunk)) < end) {
+            last = std::min(first + chunk, end);
+
+            for (int i = first; i < last; ++i) {
+                func(worker, i);
+            }
+        }
+    };
+
+    for (int worker = 1; worker < nr_threads; ++worker) {
+        workers.push_back(std::thread(work, worker));
+    }
+
+    work(0);
+
+    for (auto it = workers.begin(); it != workers.end(); ++it) {
+        it->join();
+    }
+}
+
+#endif  // PARALLEL_FOR_H_
@@ -0,0 +1,121 @@
+// Copyright 2019 Nedelcu Horia (nedelcu.horia.alexandru@gmail.com)
+
+/**
+ * query_cache.h
+ */
+
+#ifndef QUERY_CACHE_H_
+#define QUERY_CACHE_H_
+
+#include <vector>
+
+/**
+ * Bounded cache of (src, dst) -> distance results. Every entry is tagged
+ * with the graph epoch it was computed in and only answers lookups made in
+ * the same epoch, so a graph change invalidates everything in O(1).
+ * Direct-mapped: a new result overwrites whatever shared its slot.
+ */
+class QueryCache {
+ private:
+    struct Entry {
+        unsigned long long epoch_;
+        int src_, dst_, dist_;
+    };
+
+    std::vector<Entry> entries_;
+    unsigned int mask_;
+    unsigned long long hits_, misses_;
+
+    // Return the slot of a (src, dst) pair
+    inline unsigned int slot(int src, int dst) const;
+
+ public:
+    /**
+     * Constructor.
+     *
+     * @param capacity Number of slots, rounded up to a power of two.
+     */
+    explicit QueryCache(int capacity);
+
+    // Destructor
+    ~QueryCache();
+
+    /**
+     * Looks a result up.
+     *
+     * @param epoch Current epoch of the graph.
+     * @param dist Set to the cached distance on a hit.
+     * @return True on a hit, False otherwise.
+     */
+    inline bool lookup(int src, int dst, unsigned long long epoch, int *dist);
+
+    // Stores a result computed in the given epoch
+    inline void store(int src, int dst, unsigned long long epoch, int dist);
+
+    // Return number of lookups answered from the cache
+    unsigned long long getHits() const;
+
+    // Return number of lookups that missed
+    unsigned long long getMisses() const;
+
+    // Return number of slots
+    int getCapacity() const;
+};
+
+inline QueryCache::QueryCache(int capacity): entries_(), mask_(0),
+    hits_(0), misses_(0) {
+    unsigned int size = 1;
+
+    while ((int)size < capacity) {
+        size <<= 1;
+    }
+
+    entries_.assign(size, Entry{0, -1, -1, -1});
+    mask_ = size - 1;
+}
+
+inline QueryCache::~QueryCache() {}
+
+inline unsigned int QueryCache::slot(int src, int dst) const {
+    unsigned int hash = (unsigned int)src * 0x9E3779B1u ^ (unsigned int)dst;
+
+    return (hash ^ hash >> 15) & mask_;
+}
+
+inline bool QueryCache::lookup(int src, int dst, unsigned long long epoch,
+                               int *dist) {
+    const Entry& entry = entries_[slot(src, dst)];
+
+    if (entry.src_ == src && entry.dst_ == dst && entry.epoch_ == epoch) {
+        *dist = entry.dist_;
+        hits_++;
+        return true;
+    }
+
+    misses_++;
+    return false;
+}
+
+inline void QueryCache::store(int src, int dst, unsigned long long epoch,
+                              int dist) {
+    Entry& entry = entries_[slot(src, dst)];
+
+    entry.epoch_ = epoch;
+    entry.src_ = src;
+    entry.dst_ = dst;
+    entry.dist_ = dist;
+}
+
+inline unsigned long long QueryCache::getHits() const {
+    return hits_;
+}
+
+inline unsigned long long QueryCache::getMisses() const {
+    return misses_;
+}
+
+inline int QueryCache::getCapacity() const {
+    return entries_.size();
+}
+
+#endif  // QUERY_CACHE_H_
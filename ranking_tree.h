@@ -0,0 +1,360 @@
+// Copyright 2019 Nedelcu Horia (nedelcu.horia.alexandru@gmail.com)
+
+/**
+ * ranking_tree.h
+ */
+
+#ifndef RANKING_TREE_H_
+#define RANKING_TREE_H_
+
+#include <climits>
+#include <vector>
+
+/**
+ * Ranking in decreasing order: element a comes before element b when
+ * compare(b, a), the same order SortedList kept. Implemented as a treap
+ * (randomized balanced tree) whose nodes know their subtree size, so
+ * insert, remove, update and rank are O(log n) expected.
+ *
+ * Every element is inserted with a handle (a small non-negative id, like
+ * a driver index), used to find it again after its key changed outside.
+ * The comparator must order any two stored elements strictly.
+ */
+template <typename T>
+class RankingTree {
+ private:
+    /**
+     * Nodes live in one pool and link by index; freed nodes are chained
+     * through left_ and reused.
+     */
+    struct Node {
+        T value_;
+        int left_, right_, size_;
+        unsigned int priority_;
+    };
+
+    std::vector<Node> pool_;
+    std::vector<int> node_of_;  // handle -> node, -1 if not in the ranking
+    int root_, free_;
+    int changed_;  // smallest rank changed since the last clearChanged()
+    long long moves_;
+    unsigned int seed_;
+    bool (*compare_)(const T&, const T&);
+
+    // Return true if a ranks before b
+    inline bool before(const T& a, const T& b);
+
+    // Return a node holding value, from the free chain if possible
+    int newNode(const T& value);
+
+    // Recomputes the subtree size of a node
+    inline void pull(int node);
+
+    // Splits a subtree in the nodes before value and the rest
+    void split(int node, const T& value, int& left, int& right);
+
+    // Joins two subtrees, all of left ranking before all of right
+    int merge(int left, int right);
+
+    // Unlinks target (whose value is value) from a subtree
+    int unlink(int node, const T& value, int target);
+
+    // Takes out the element with the given handle; return its rank
+    int detach(int handle);
+
+ public:
+    // Constructor
+    explicit RankingTree(bool (*c)(const T&, const T&));
+
+    // Destructor
+    ~RankingTree();
+
+    // Insert an element in order, replacing the one with the same handle
+    void insert(int handle, const T&);
+
+    // Remove the element with the given handle
+    void remove(int handle);
+
+    // Replace the element with the given handle and move it to its new rank
+    void update(int handle, const T&);
+
+    // Return true if there is an element with the given handle
+    bool contains(int handle);
+
+    // Return 0-based rank of the element with the given handle
+    int rank(int handle);
+
+    // Return number of elements
+    int getSize();
+
+    /**
+     * Visits the elements ranked first..last-1 in order, without copying.
+     *
+     * @param visit Called with a const reference to every element.
+     */
+    template <typename Func>
+    void visitRange(int first, int last, Func visit);
+
+    // Visits the first k elements in order
+    template <typename Func>
+    void visitTop(int k, Func visit);
+
+    /**
+     * Gets the smallest rank whose element was inserted, removed or moved
+     * since the last clearChanged(); the elements ranked before it are the
+     * same as then.
+     *
+     * @return the rank, or INT_MAX if nothing changed.
+     */
+    int getChanged();
+
+    // Forgets the changes made so far
+    void clearChanged();
+
+    // Return the ranks elements moved by in updates, summed over all of them
+    long long getMoves();
+};
+
+template <typename T>
+RankingTree<T>::RankingTree(bool (*c)(const T&, const T&)):
+    pool_(), node_of_(), root_(-1), free_(-1), changed_(0), moves_(0),
+    seed_(2463534242u), compare_(c) {}
+
+template <typename T>
+RankingTree<T>::~RankingTree() {}
+
+template <typename T>
+inline bool RankingTree<T>::before(const T& a, const T& b) {
+    return compare_(b, a);
+}
+
+template <typename T>
+int RankingTree<T>::newNode(const T& value) {
+    int node;
+
+    // xorshift32 priorities keep the treap balanced in expectation
+    seed_ ^= seed_ << 13;
+    seed_ ^= seed_ >> 17;
+    seed_ ^= seed_ << 5;
+
+    if (free_ != -1) {
+        node = free_;
+        free_ = pool_[node].left_;
+    } else {
+        node = pool_.size();
+        pool_.push_back(Node());
+    }
+
+    pool_[node].value_ = value;
+    pool_[node].left_ = pool_[node].right_ = -1;
+    pool_[node].size_ = 1;
+    pool_[node].priority_ = seed_;
+
+    return node;
+}
+
+template <typename T>
+inline void RankingTree<T>::pull(int node) {
+    pool_[node].size_ = 1 +
+        (pool_[node].left_ != -1? pool_[pool_[node].left_].size_: 0) +
+        (pool_[node].right_ != -1? pool_[pool_[node].right_].size_: 0);
+}
+
+template <typename T>
+void RankingTree<T>::split(int node, const T& value, int& left, int& right) {
+    if (node == -1) {
+        left = right = -1;
+        return;
+    }
+
+    if (before(pool_[node].value_, value)) {
+        split(pool_[node].right_, value, pool_[node].right_, right);
+        left = node;
+    } else {
+        split(pool_[node].left_, value, left, pool_[node].left_);
+        right = node;
+    }
+
+    pull(node);
+}
+
+template <typename T>
+int RankingTree<T>::merge(int left, int right) {
+    if (left == -1 || right == -1) {
+        return (left == -1)? right: left;
+    }
+
+    if (pool_[left].priority_ > pool_[right].priority_) {
+        pool_[left].right_ = merge(pool_[left].right_, right);
+        pull(left);
+        return left;
+    }
+
+    pool_[right].left_ = merge(left, pool_[right].left_);
+    pull(right);
+    return right;
+}
+
+template <typename T>
+int RankingTree<T>::unlink(int node, const T& value, int target) {
+    if (node == target) {
+        return merge(pool_[node].left_, pool_[node].right_);
+    }
+
+    if (before(value, pool_[node].value_)) {
+        pool_[node].left_ = unlink(pool_[node].left_, value, target);
+    } else {
+        pool_[node].right_ = unlink(pool_[node].right_, value, target);
+    }
+
+    pull(node);
+    return node;
+}
+
+template <typename T>
+void RankingTree<T>::insert(int handle, const T& element) {
+    int node, left, right, old_rank, new_rank;
+
+    old_rank = contains(handle)? detach(handle): -1;
+    node = newNode(element);
+
+    if ((int)node_of_.size() <= handle) {
+        node_of_.resize(handle + 1, -1);
+    }
+    node_of_[handle] = node;
+
+    // like SortedList, a new element goes before the ones equal to it
+    split(root_, element, left, right);
+    new_rank = (left == -1)? 0: pool_[left].size_;
+
+    if (new_rank < changed_) {
+        changed_ = new_rank;
+    }
+    if (old_rank != -1) {
+        moves_ += (old_rank > new_rank)? old_rank - new_rank:
+                                         new_rank - old_rank;
+    }
+    root_ = merge(merge(left, node), right);
+}
+
+template <typename T>
+void RankingTree<T>::remove(int handle) {
+    if (contains(handle)) {
+        detach(handle);
+    }
+}
+
+template <typename T>
+int RankingTree<T>::detach(int handle) {
+    int node = node_of_[handle], old_rank = rank(handle);
+
+    if (old_rank < changed_) {
+        changed_ = old_rank;
+    }
+
+    // the stored copy still has the key the node was placed with
+    root_ = unlink(root_, pool_[node].value_, node);
+
+    pool_[node].left_ = free_;
+    free_ = node;
+    node_of_[handle] = -1;
+
+    return old_rank;
+}
+
+template <typename T>
+void RankingTree<T>::update(int handle, const T& element) {
+    insert(handle, element);
+}
+
+template <typename T>
+bool RankingTree<T>::contains(int handle) {
+    return handle >= 0 && handle < (int)node_of_.size() &&
+           node_of_[handle] != -1;
+}
+
+template <typename T>
+int RankingTree<T>::rank(int handle) {
+    int target = node_of_[handle], node = root_, result = 0;
+    const T& value = pool_[target].value_;
+
+    while (node != target) {
+        if (before(value, pool_[node].value_)) {
+            node = pool_[node].left_;
+        } else {
+            result += 1 + (pool_[node].left_ != -1?
+                           pool_[pool_[node].left_].size_: 0);
+            node = pool_[node].right_;
+        }
+    }
+
+    if (pool_[node].left_ != -1) {
+        result += pool_[pool_[node].left_].size_;
+    }
+
+    return result;
+}
+
+template <typename T>
+int RankingTree<T>::getSize() {
+    return (root_ == -1)? 0: pool_[root_].size_;
+}
+
+template <typename T>
+template <typename Func>
+void RankingTree<T>::visitRange(int first, int last, Func visit) {
+    std::vector<int> stack;
+    int node = root_, left_size, k;
+
+    // descend to the element ranked first, keeping the nodes after it
+    while (node != -1) {
+        left_size = (pool_[node].left_ != -1)?
+                    pool_[pool_[node].left_].size_: 0;
+
+        if (first < left_size) {
+            stack.push_back(node);
+            node = pool_[node].left_;
+        } else if (first == left_size) {
+            stack.push_back(node);
+            break;
+        } else {
+            first -= left_size + 1;
+            last -= left_size + 1;
+            node = pool_[node].right_;
+        }
+    }
+
+    // in-order walk from there
+    for (k = first; k < last && !stack.empty(); ++k) {
+        node = stack.back();
+        stack.pop_back();
+        visit(static_cast<const T&>(pool_[node].value_));
+
+        for (node = pool_[node].right_; node != -1; node = pool_[node].left_) {
+            stack.push_back(node);
+        }
+    }
+}
+
+template <typename T>
+template <typename Func>
+void RankingTree<T>::visitTop(int k, Func visit) {
+    visitRange(0, k, visit);
+}
+
+template <typename T>
+int RankingTree<T>::getChanged() {
+    return changed_;
+}
+
+template <typename T>
+void RankingTree<T>::clearChanged() {
+    changed_ = INT_MAX;
+}
+
+template <typename T>
+long long RankingTree<T>::getMoves() {
+    return moves_;
+}
+
+#endif  // RANKING_TREE_H_
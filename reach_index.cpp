@@ -0,0 +1,136 @@
+// Copyright 2019 Nedelcu Horia (nedelcu.horia.alexandru@gmail.com)
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include "./reach_index.h"
+
+ReachIndex::ReachIndex(): nr_comps_(0), words_(0), comp_(), closure_() {}
+
+ReachIndex::~ReachIndex() {}
+
+int ReachIndex::findComponents(int size, const int *offsets,
+                               const int *degree, const int *targets,
+                               std::vector<int>& comp) {
+    std::vector<int> index(size, -1), low(size, 0), stack;
+    std::vector<std::pair<int, int>> call;  // (node, next neighbor)
+    std::vector<bool> on_stack(size, false);
+    int root, node, next, counter = 0, nr_comps = 0;
+
+    comp.assign(size, -1);
+
+    // iterative Tarjan; a component gets its number when it is closed, so
+    // sinks are numbered first
+    for (root = 0; root < size; ++root) {
+        if (index[root] != -1) {
+            continue;
+        }
+
+        index[root] = low[root] = counter++;
+        stack.push_back(root);
+        on_stack[root] = true;
+        call.push_back(std::make_pair(root, 0));
+
+        while (!call.empty()) {
+            node = call.back().first;
+
+            if (call.back().second < degree[node]) {
+                next = targets[offsets[node] + call.back().second++];
+
+                if (index[next] == -1) {
+                    index[next] = low[next] = counter++;
+                    stack.push_back(next);
+                    on_stack[next] = true;
+                    call.push_back(std::make_pair(next, 0));
+                } else if (on_stack[next]) {
+                    low[node] = std::min(low[node], index[next]);
+                }
+                continue;
+            }
+
+            call.pop_back();
+
+            if (low[node] == index[node]) {
+                do {
+                    next = stack.back();
+                    stack.pop_back();
+                    on_stack[next] = false;
+                    comp[next] = nr_comps;
+                } while (next != node);
+                nr_comps++;
+            }
+
+            if (!call.empty()) {
+                next = call.back().first;
+                low[next] = std::min(low[next], low[node]);
+            }
+        }
+    }
+
+    return nr_comps;
+}
+
+void ReachIndex::build(int size, const int *offsets, const int *degree,
+                       const int *targets) {
+    int node;
+
+    clear();
+    nr_comps_ = findComponents(size, offsets, degree, targets, comp_);
+
+    words_ = (nr_comps_ + 63) / 64;
+    if ((double)nr_comps_ * words_ * sizeof(uint64_t) >
+        REACH_CLOSURE_MAX_BYTES) {
+        return;  // only the component order is used
+    }
+
+    // Successors have lower numbers, so rows are filled in increasing
+    // order, each one as the OR of its successors' rows.
+    std::vector<std::vector<int>> members(nr_comps_);
+    for (node = 0; node < size; ++node) {
+        members[comp_[node]].push_back(node);
+    }
+
+    closure_.assign((size_t)nr_comps_ * words_, 0);
+    for (int c = 0; c < nr_comps_; ++c) {
+        uint64_t *row = &closure_[(size_t)c * words_];
+
+        row[c >> 6] |= 1ULL << (c & 63);
+
+        for (auto it = members[c].begin(); it != members[c].end(); ++it) {
+            for (int i = 0; i < degree[*it]; ++i) {
+                int to = comp_[targets[offsets[*it] + i]];
+
+                // skip inner edges and components already merged in
+                if (to == c || (row[to >> 6] >> (to & 63) & 1)) {
+                    continue;
+                }
+
+                const uint64_t *other = &closure_[(size_t)to * words_];
+                for (int w = 0; w <= (to >> 6); ++w) {
+                    row[w] |= other[w];
+                }
+            }
+        }
+    }
+}
+
+void ReachIndex::clear() {
+    nr_comps_ = 0;
+    words_ = 0;
+    comp_.clear();
+    comp_.shrink_to_fit();
+    closure_.clear();
+    closure_.shrink_to_fit();
+}
+
+bool ReachIndex::isBuilt() const {
+    return !comp_.empty();
+}
+
+int ReachIndex::getComponents() const {
+    return nr_comps_;
+}
+
+size_t ReachIndex::getClosureBytes() const {
+    return closure_.size() * sizeof(uint64_t);
+}
@@ -0,0 +1,223 @@
+// Copyright 2019 Nedelcu Horia (nedelcu.horia.alexandru@gmail.com)
+
+/**
+ * reach_index.h
+ */
+
+#ifndef REACH_INDEX_H_
+#define REACH_INDEX_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// largest transitive closure, in bytes, the index is allowed to keep
+#define REACH_CLOSURE_MAX_BYTES (128u << 20)
+
+/**
+ * Reachability index of a directed graph. Nodes are grouped in strongly
+ * connected components (Tarjan), numbered so that every edge between two
+ * components goes from a higher to a lower number (reverse topological
+ * order of the condensation DAG). Each component then keeps a bitset of
+ * the components it reaches, when that fits in REACH_CLOSURE_MAX_BYTES.
+ */
+class ReachIndex {
+ private:
+    int nr_comps_;
+    int words_;                      // 64-bit words per closure row
+    std::vector<int> comp_;          // node -> component
+    std::vector<uint64_t> closure_;  // component -> reached components
+
+ public:
+    // Constructor
+    ReachIndex();
+
+    /**
+     * Splits a CSR graph in strongly connected components (iterative
+     * Tarjan), numbered so that edges between two components go from the
+     * higher number to the lower one.
+     *
+     * @param comp Filled with the component of every node.
+     * @return number of components.
+     */
+    static int findComponents(int size, const int *offsets,
+                              const int *degree, const int *targets,
+                              std::vector<int>& comp);
+
+    // Destructor
+    ~ReachIndex();
+
+    /**
+     * Builds the index from a CSR adjacency.
+     *
+     * @param size Number of nodes.
+     * @param offsets Start of each node's row in targets.
+     * @param degree Number of neighbors in each row.
+     * @param targets Neighbors.
+     */
+    void build(int size, const int *offsets, const int *degree,
+               const int *targets);
+
+    // Frees the index; reaches() can't tell anything until the next build
+    void clear();
+
+    // Return true if the index was built and not cleared since
+    bool isBuilt() const;
+
+    /**
+     * Checks if there is a path from a node to another one.
+     *
+     * @return 1 if there is a path, 0 if there is none, -1 if the index
+     * can't tell (not built, or built without the closure).
+     */
+    inline int reaches(int src, int dst) const;
+
+    // Return number of strongly connected components
+    int getComponents() const;
+
+    // Return memory used by the closure bitsets
+    size_t getClosureBytes() const;
+};
+
+inline int ReachIndex::reaches(int src, int dst) const {
+    if (comp_.empty()) {
+        return -1;
+    }
+
+    int from = comp_[src], to = comp_[dst];
+
+    if (from == to) {
+        return 1;
+    }
+
+    if (from < to) {  // edges only go to lower components
+        return 0;
+    }
+
+    if (closure_.empty()) {
+        return -1;
+    }
+
+    return closure_[(size_t)from * words_ + (to >> 6)] >> (to & 63) & 1;
+}
+
+/**
+ * Bounds every finite distance of a frozen graph (a ListGraph) in O(V + E),
+ * so that a distance matrix can be made no wider than it needs before it
+ * is filled. Inside a strongly connected component, a distance is at most
+ * the way into one of its nodes plus the way back out, both measured
+ * along BFS trees grown inside the component. A path visits components in
+ * the order of the condensation DAG, so the bound is the longest path of
+ * the DAG, where every component weighs its own bound and every edge
+ * between two components weighs its weight.
+ *
+ * @return a bound on every finite distance, no more than
+ * (size - 1) * max weight.
+ */
+template <typename Graph>
+long long distBound(Graph& graph) {
+    typename Graph::CSR out = graph.getCSR(false), in = graph.getCSR(true);
+    int size = graph.getSize(), nr_comps, node, next, e;
+    std::vector<int> comp, order, first, queue;
+    std::vector<long long> dist(size, -1), bound;
+    long long result = 0;
+
+    if (!size) {
+        return 0;
+    }
+
+    nr_comps = ReachIndex::findComponents(size, out.offsets, out.degree,
+                                          out.targets, comp);
+
+    // nodes grouped by component; the first one roots its BFS trees
+    first.assign(nr_comps + 1, 0);
+    for (node = 0; node < size; ++node) {
+        first[comp[node] + 1]++;
+    }
+    for (int c = 0; c < nr_comps; ++c) {
+        first[c + 1] += first[c];
+    }
+    order.resize(size);
+    for (node = 0; node < size; ++node) {
+        order[first[comp[node]]++] = node;
+    }
+    for (int c = nr_comps; c > 0; --c) {
+        first[c] = first[c - 1];
+    }
+    first[0] = 0;
+
+    // way out of the root along out-edges, then way in along in-edges
+    bound.assign(nr_comps, 0);
+    for (int side = 0; side < 2; ++side) {
+        const typename Graph::CSR& rows = side? in: out;
+
+        for (int c = 0; c < nr_comps; ++c) {
+            long long far = 0;
+
+            queue.assign(1, order[first[c]]);
+            dist[order[first[c]]] = 0;
+
+            for (unsigned int i = 0; i < queue.size(); ++i) {
+                node = queue[i];
+                far = std::max(far, dist[node]);
+
+                for (e = rows.offsets[node];
+                    e < rows.offsets[node] + rows.degree[node]; ++e) {
+                    next = rows.targets[e];
+
+                    if (comp[next] == c && dist[next] == -1) {
+                        dist[next] = dist[node] +
+                                     (rows.weights? rows.weights[e]: 1);
+                        queue.push_back(next);
+                    }
+                }
+            }
+
+            for (auto it = queue.begin(); it != queue.end(); ++it) {
+                dist[*it] = -1;
+            }
+            bound[c] += far;
+        }
+    }
+
+    // edges lead to lower components, whose longest paths are known
+    for (int c = 0; c < nr_comps; ++c) {
+        long long tail = 0;
+
+        for (int i = first[c]; i < first[c + 1]; ++i) {
+            node = order[i];
+
+            for (e = out.offsets[node];
+                e < out.offsets[node] + out.degree[node]; ++e) {
+                next = out.targets[e];
+
+                if (comp[next] != c) {
+                    tail = std::max(tail, bound[comp[next]] +
+                                    (out.weights? out.weights[e]: 1));
+                }
+            }
+        }
+
+        bound[c] += tail;
+        result = std::max(result, bound[c]);
+    }
+
+    return std::min(result, (long long)(size - 1) * graph.getMaxWeight());
+}
+
+/**
+ * Builds the reachability index of a frozen graph (a ListGraph) from its
+ * CSR rows. Edge changes made after it are not seen; clear the index then.
+ *
+ * @param graph Frozen graph.
+ * @param index Index that gets built.
+ */
+template <typename Graph>
+void buildReachIndex(Graph& graph, ReachIndex& index) {
+    typename Graph::CSR out = graph.getCSR(false);
+
+    index.build(graph.getSize(), out.offsets, out.degree, out.targets);
+}
+
+#endif  // REACH_INDEX_H_
@@ -0,0 +1,263 @@
+// Copyright 2019 Nedelcu Horia (nedelcu.horia.alexandru@gmail.com)
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "./snapshot.h"
+
+// Return offset rounded up to a multiple of SNAPSHOT_ALIGN
+static uint64_t align_up(uint64_t offset) {
+    return (offset + SNAPSHOT_ALIGN - 1) / SNAPSHOT_ALIGN * SNAPSHOT_ALIGN;
+}
+
+Snapshot::Snapshot(): map_(nullptr), map_size_(0), header_(nullptr) {}
+
+Snapshot::~Snapshot() {
+    close();
+}
+
+uint64_t Snapshot::sectionSize(const Header& header, int section) {
+    uint64_t nodes = header.nodes;
+
+    switch (section) {
+        case OFFSETS:
+            return (nodes + 1) * sizeof(int32_t);
+        case TARGETS:
+            return (uint64_t)header.edges * sizeof(int32_t);
+        case WEIGHTS:
+            return header.weighted? (uint64_t)header.edges * sizeof(int32_t):
+                                    0;
+        case NAME_STARTS:
+            return (nodes + 1) * sizeof(uint64_t);
+        case NAMES:
+            return header.name_bytes;
+        default:
+            return nodes * nodes * header.dist_width;
+    }
+}
+
+const void *Snapshot::sectionData(int section) const {
+    return static_cast<const char *>(map_) + header_->section[section];
+}
+
+bool Snapshot::save(const char *path, const std::vector<int>& offsets,
+                    const std::vector<int>& targets,
+                    const std::vector<int>& weights,
+                    const std::vector<std::string_view>& names,
+                    const DistMatrix& dist) {
+    std::string temp = std::string(path) + ".tmp";
+    std::vector<uint64_t> starts(names.size() + 1, 0);
+    std::vector<char> padding(SNAPSHOT_ALIGN, 0);
+    const void *data[SECTIONS];
+    uint64_t position = sizeof(Header);
+    Header header;
+    bool written;
+
+    // the matrix has to be the one of this graph
+    if (dist.getSize() != (int)names.size() ||
+        offsets.size() != names.size() + 1 ||
+        (!weights.empty() && weights.size() != targets.size())) {
+        return false;
+    }
+
+    for (unsigned int i = 0; i < names.size(); ++i) {
+        starts[i + 1] = starts[i] + names[i].size();
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byte_order = SNAPSHOT_BYTE_ORDER;
+    header.nodes = names.size();
+    header.dist_width = dist.getWidth();
+    header.weighted = !weights.empty();
+    header.edges = targets.size();
+    header.name_bytes = starts.back();
+
+    data[OFFSETS] = offsets.data();
+    data[TARGETS] = targets.data();
+    data[WEIGHTS] = weights.data();
+    data[NAME_STARTS] = starts.data();
+    data[NAMES] = nullptr;  // written name by name
+    data[DIST] = dist.getData();
+
+    for (int s = 0; s < SECTIONS; ++s) {
+        header.section[s] = position = align_up(position);
+        position += sectionSize(header, s);
+    }
+
+    FILE *file = std::fopen(temp.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+
+    written = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    position = sizeof(header);
+
+    for (int s = 0; s < SECTIONS && written; ++s) {
+        uint64_t size = sectionSize(header, s);
+
+        written = std::fwrite(padding.data(), 1, header.section[s] - position,
+                              file) == header.section[s] - position;
+
+        if (s == NAMES) {
+            for (auto it = names.begin(); it != names.end() && written; ++it) {
+                written = std::fwrite(it->data(), 1, it->size(), file) ==
+                          it->size();
+            }
+        } else if (size) {
+            written = written && std::fwrite(data[s], 1, size, file) == size;
+        }
+
+        position = header.section[s] + size;
+    }
+
+    written = (std::fclose(file) == 0) && written;
+
+    if (!written || std::rename(temp.c_str(), path) != 0) {
+        std::remove(temp.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool Snapshot::open(const char *path) {
+    struct stat info;
+    int fd = ::open(path, O_RDONLY);
+
+    close();
+
+    if (fd == -1) {
+        return false;
+    }
+
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) &&
+        (size_t)info.st_size >= sizeof(Header)) {
+        map_ = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (map_ == MAP_FAILED) {
+            map_ = nullptr;
+        } else {
+            map_size_ = info.st_size;
+            header_ = static_cast<const Header *>(map_);
+        }
+    }
+
+    ::close(fd);
+
+    if (map_ && !validate()) {
+        close();
+    }
+
+    return map_ != nullptr;
+}
+
+bool Snapshot::validate() const {
+    const int32_t *offsets, *targets, *weights;
+    const uint64_t *starts;
+    uint64_t end = sizeof(Header);
+
+    if (memcmp(header_->magic, SNAPSHOT_MAGIC, sizeof(header_->magic)) ||
+        header_->version != SNAPSHOT_VERSION ||
+        header_->byte_order != SNAPSHOT_BYTE_ORDER || header_->nodes < 0 ||
+        (header_->weighted != 0 && header_->weighted != 1) ||
+        header_->edges < 0 || (header_->dist_width != 1 &&
+        header_->dist_width != 2 && header_->dist_width != 4)) {
+        return false;
+    }
+
+    // sections in order, aligned, inside the file
+    for (int s = 0; s < SECTIONS; ++s) {
+        if (header_->section[s] < end ||
+            header_->section[s] % SNAPSHOT_ALIGN ||
+            header_->section[s] > map_size_ ||
+            sectionSize(*header_, s) > map_size_ - header_->section[s]) {
+            return false;
+        }
+        end = header_->section[s] + sectionSize(*header_, s);
+    }
+
+    // rows and names have to stay inside their arrays
+    offsets = static_cast<const int32_t *>(sectionData(OFFSETS));
+    targets = static_cast<const int32_t *>(sectionData(TARGETS));
+    weights = static_cast<const int32_t *>(sectionData(WEIGHTS));
+    starts = static_cast<const uint64_t *>(sectionData(NAME_STARTS));
+
+    if (offsets[0] != 0 || offsets[header_->nodes] != header_->edges ||
+        starts[0] != 0 || starts[header_->nodes] != header_->name_bytes) {
+        return false;
+    }
+
+    for (int i = 0; i < header_->nodes; ++i) {
+        if (offsets[i] > offsets[i + 1] || starts[i] > starts[i + 1]) {
+            return false;
+        }
+    }
+
+    for (int64_t e = 0; e < header_->edges; ++e) {
+        if (targets[e] < 0 || targets[e] >= header_->nodes ||
+            (header_->weighted && weights[e] < 1)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void Snapshot::close() {
+    if (map_) {
+        munmap(map_, map_size_);
+    }
+
+    map_ = nullptr;
+    map_size_ = 0;
+    header_ = nullptr;
+}
+
+bool Snapshot::isOpen() const {
+    return map_ != nullptr;
+}
+
+int Snapshot::getNodes() const {
+    return header_->nodes;
+}
+
+const int *Snapshot::getOffsets() const {
+    return static_cast<const int *>(sectionData(OFFSETS));
+}
+
+const int *Snapshot::getTargets() const {
+    return static_cast<const int *>(sectionData(TARGETS));
+}
+
+std::string_view Snapshot::getName(int node) const {
+    const uint64_t *starts =
+        static_cast<const uint64_t *>(sectionData(NAME_STARTS));
+
+    return std::string_view(static_cast<const char *>(sectionData(NAMES)) +
+                            starts[node], starts[node + 1] - starts[node]);
+}
+
+const int *Snapshot::getWeights() const {
+    if (!header_->weighted) {
+        return nullptr;
+    }
+
+    return static_cast<const int *>(sectionData(WEIGHTS));
+}
+
+const uint8_t *Snapshot::getDist() const {
+    return static_cast<const uint8_t *>(sectionData(DIST));
+}
+
+int Snapshot::getDistWidth() const {
+    return header_->dist_width;
+}
@@ -0,0 +1,125 @@
+// Copyright 2019 Nedelcu Horia (nedelcu.horia.alexandru@gmail.com)
+
+/**
+ * snapshot.h
+ */
+
+#ifndef SNAPSHOT_H_
+#define SNAPSHOT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "./dist_matrix.h"
+
+// first bytes of every snapshot file
+#define SNAPSHOT_MAGIC "UBERSNAP"
+// bumped on any layout change; other versions are rejected, not misread
+#define SNAPSHOT_VERSION 2
+// written as is, reads back different on a host of the other byte order
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+// sections start at multiples of this many bytes
+#define SNAPSHOT_ALIGN 64
+
+/**
+ * Binary image of the city as task3 leaves it: the graph in CSR form (with
+ * the road lengths, if any), the intersection names and the distance
+ * matrix. The file is a header and then one aligned section per array, in
+ * host byte order, so it is mapped and read in place: loading parses
+ * nothing, and the matrix pages are only read from disk once dispatch
+ * touches them. The graph and name arrays are small next to the matrix;
+ * the solver copies them into its own structures.
+ */
+class Snapshot {
+ private:
+    // Sections of the file, in file order
+    enum Section {OFFSETS, TARGETS, WEIGHTS, NAME_STARTS, NAMES, DIST,
+                  SECTIONS};
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t byte_order;
+        int32_t nodes;
+        int32_t dist_width;
+        int32_t weighted;     // 1 if the WEIGHTS section is there
+        int32_t reserved;
+        int64_t edges;
+        uint64_t name_bytes;
+        uint64_t section[SECTIONS];  // file offset of every section
+    };
+
+    void *map_;
+    size_t map_size_;
+    const Header *header_;
+
+    // Return the size in bytes of a section of the given header
+    static uint64_t sectionSize(const Header& header, int section);
+
+    // Return a section of the mapped file
+    const void *sectionData(int section) const;
+
+    // Return true if the mapped header and arrays are consistent
+    bool validate() const;
+
+ public:
+    // Constructor; nothing is mapped
+    Snapshot();
+
+    // Destructor; unmaps the file
+    ~Snapshot();
+
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+
+    /**
+     * Writes a snapshot. The file is written under a temporary name and
+     * renamed over path once complete, so a reader never maps half of it.
+     *
+     * @param offsets size + 1 CSR row starts, as ListGraph::exportCSR.
+     * @param targets CSR edge destinations.
+     * @param weights CSR edge weights, empty if the graph is not weighted.
+     * @param names Name of every node.
+     * @param dist Distance matrix of the graph.
+     * @return True if the file was written, False otherwise.
+     */
+    static bool save(const char *path, const std::vector<int>& offsets,
+                     const std::vector<int>& targets,
+                     const std::vector<int>& weights,
+                     const std::vector<std::string_view>& names,
+                     const DistMatrix& dist);
+
+    /**
+     * Maps a snapshot, unmapping the one opened before.
+     *
+     * @return True if the file is a complete snapshot of this version and
+     * byte order, False otherwise (then nothing is mapped).
+     */
+    bool open(const char *path);
+
+    // Unmaps the file; the arrays given out before are no longer valid
+    void close();
+
+    // Return true if a snapshot is mapped
+    bool isOpen() const;
+
+    // Return number of nodes
+    int getNodes() const;
+
+    // Return the CSR row starts (nodes + 1) and edge destinations
+    const int *getOffsets() const;
+    const int *getTargets() const;
+
+    // Return the edge weights, nullptr if the graph is not weighted
+    const int *getWeights() const;
+
+    // Return the name of a node
+    std::string_view getName(int node) const;
+
+    // Return the distance matrix elements and their width in bytes
+    const uint8_t *getDist() const;
+    int getDistWidth() const;
+};
+
+#endif  // SNAPSHOT_H_
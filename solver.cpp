@@ -1,18 +1,18 @@
 // Copyright 2019 Nedelcu Horia (nedelcu.horia.alexandru@gmail.com)
 
+#include <algorithm>
+#include <charconv>
+#include <climits>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
 #include <utility>
 #include <string>
+#include <thread>
 #include <vector>
 #include <list>
 #include "./solver.h"
 
-template <class T>
-void swap(T& a, T& b) {
-    T c(std::move(a));
-    a = std::move(b);
-    b = std::move(c);
-}
-
 bool operator==(const Driver &lhs, const Driver &rhs) {
     return lhs.id == rhs.id;
 }
@@ -65,42 +65,403 @@ bool comp_dist(const Driver &lhs, const Driver &rhs) {
     return false;
 }
 
-bool comp_uber(const Driver &lhs, const Driver &rhs,
-    int src, const std::vector<std::vector<int>> &dist) {
-    if (lhs.status < rhs.status) {
-        return true;
-    } else if (lhs.status == rhs.status &&
-               dist[rhs.node][src] != -1 &&
-               (dist[lhs.node][src] == -1 ||
-                dist[lhs.node][src] > dist[rhs.node][src])) {
-        return true;
-    } else if (lhs.status == rhs.status &&
-               dist[lhs.node][src] == dist[rhs.node][src]) {
-        return comp_rating(lhs, rhs);
+void format_rating(std::string& line, const Driver& driver) {
+    char buffer[330];
+    double rating = driver.nr_races? driver.rating / driver.nr_races: 0.0;
+
+    line += driver.name;
+    line += ':';
+    line.append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), rating,
+                                      std::chars_format::fixed, 3).ptr);
+    line += ' ';
+}
+
+void format_races(std::string& line, const Driver& driver) {
+    line += driver.name;
+    line += ':';
+    line += std::to_string(driver.nr_races);
+    line += ' ';
+}
+
+void format_dist(std::string& line, const Driver& driver) {
+    line += driver.name;
+    line += ':';
+    line += std::to_string(driver.dist);
+    line += ' ';
+}
+
+solver::solver(): snapshot(), dist_graph(), dist_labels(), names(),
+    hash_graph(HASH_INITIAL_CAPACITY, string_hash), graph(0), reach_index(),
+    hot_dist(&graph, HOT_DIST_ROWS, HOT_DIST_AFTER),
+    query_cache(QUERY_CACHE_SLOTS),
+	hash_driver(HASH_INITIAL_CAPACITY, string_hash), drivers(),
+    driver_table(),
+	rating_top(comp_rating), races_top(comp_races), dist_top(comp_dist),
+    nr_threads(std::thread::hardware_concurrency()), dist_transposed(false),
+    dist_by_labels(false),
+    stats(std::getenv("UBER_STATS") != nullptr), event_latency(),
+    dispatch_scanned(0), input(), input_stream(nullptr),
+    snapshot_load_path(), snapshot_save_path() {
+    const char *env = std::getenv("UBER_THREADS");
+
+    if (env && std::atoi(env) > 0) {
+        nr_threads = std::atoi(env);
     }
 
-    return false;
+    if (nr_threads < 1) {
+        nr_threads = 1;
+    }
+
+    env = std::getenv("UBER_DIST_COLUMNS");
+    dist_transposed = env && std::atoi(env) > 0;
+
+    env = std::getenv("UBER_DIST_LABELS");
+    dist_by_labels = env && std::atoi(env) > 0;
+
+    hash_graph.setCountProbes(stats);
+    hash_driver.setCountProbes(stats);
+
+    env = std::getenv("UBER_SNAPSHOT");
+    snapshot_load_path = env? env: "";
+
+    env = std::getenv("UBER_SAVE_SNAPSHOT");
+    snapshot_save_path = env? env: "";
+}
+
+solver::~solver() {
+    static const char *event_names[TASK4_EVENTS] = {"d", "b", "r",
+        "top_rating", "top_dist", "top_rides", "info"};
+
+    if (!stats) {
+        return;
+    }
+
+    std::cerr << "query cache: " << query_cache.getHits() << " hits, "
+              << query_cache.getMisses() << " misses, "
+              << query_cache.getCapacity() << " slots\n";
+
+    for (int i = 0; i < TASK4_EVENTS; ++i) {
+        event_latency[i].report(std::cerr, event_names[i]);
+    }
+
+    std::cerr << "dispatch: " << dispatch_scanned << " drivers scanned\n"
+              << "leaderboards: " << rating_top.getMoves() << " rating, "
+              << races_top.getMoves() << " rides, "
+              << dist_top.getMoves() << " dist ranks moved\n"
+              << "hash_graph: " << hash_graph.getSearches() << " searches, "
+              << hash_graph.getProbes() << " groups probed, max "
+              << hash_graph.getMaxProbes() << '\n'
+              << "hash_driver: " << hash_driver.getSearches() << " searches, "
+              << hash_driver.getProbes() << " groups probed, max "
+              << hash_driver.getMaxProbes() << '\n';
+
+    if (dist_labels.isBuilt()) {
+        std::cerr << "dist labels: " << dist_labels.getEntries()
+                  << " entries, " << dist_labels.getBytes() << " bytes\n";
+    }
+}
+
+void solver::setThreads(int threads) {
+    nr_threads = (threads > 0)? threads: 1;
+}
+
+void solver::setTransposedDist(bool transposed) {
+    dist_transposed = transposed;
+}
+
+void solver::setDistLabels(bool enabled) {
+    dist_by_labels = enabled;
+}
+
+void solver::setStats(bool enabled) {
+    stats = enabled;
+    hash_graph.setCountProbes(enabled);
+    hash_driver.setCountProbes(enabled);
+}
+
+LatencyHistogram *solver::eventLatency(Task4Event event) {
+    return stats? &event_latency[event]: nullptr;
+}
+
+void solver::computeDistGraph() {
+    int n = graph.getSize(), nr_batches;
+    std::vector<ListGraph<int>::MSBFSState> state(nr_threads);
+    std::vector<int> max_dist(nr_threads, 0), sources;
+    const std::vector<int> *row;
+    // the element width comes from a bound on the diameter, before the
+    // matrix is allocated; narrow() only trims what the bound overshoots
+    int bound = (int)std::min((long long)INT_MAX - 1, distBound(graph));
+
+    if (dist_by_labels || (unsigned long long)n * n *
+        DistMatrix::widthFor(bound) > DIST_MATRIX_MAX_BYTES) {
+        dist_graph.reset(0, 0);
+        buildHubLabels(graph, dist_labels);
+        return;
+    }
+    dist_labels.clear();
+
+    dist_graph.reset(n, bound);
+
+    // rows kept through task3 are already exact
+    for (int i = 0; i < n; ++i) {
+        if ((row = hot_dist.getRow(i))) {
+            for (int j = 0; j < n; ++j) {
+                dist_graph.set(i, j, (*row)[j]);
+                max_dist[0] = std::max(max_dist[0], (*row)[j]);
+            }
+        } else {
+            sources.push_back(i);
+        }
+    }
+
+    if (graph.isWeighted()) {
+        std::vector<ListGraph<int>::BFSState> bfs(nr_threads);
+        std::vector<std::vector<int>> rows(nr_threads);
+
+        // bit-parallel BFS counts hops, so one Dial search per source
+        parallel_for(0, (int)sources.size(), 1, nr_threads,
+                     [&](int worker, int k) {
+            graph.getDistNodes(sources[k], rows[worker], bfs[worker]);
+
+            for (int j = 0; j < n; ++j) {
+                dist_graph.set(sources[k], j, rows[worker][j]);
+                max_dist[worker] = std::max(max_dist[worker],
+                                            rows[worker][j]);
+            }
+        });
+        sources.clear();
+    }
+
+    nr_batches = (sources.size() + MSBFS_BATCH - 1) / MSBFS_BATCH;
+
+    // one multi-source BFS per batch of MSBFS_BATCH sources
+    parallel_for(0, nr_batches, 1, nr_threads, [&](int worker, int batch) {
+        const int *first = sources.data() + batch * MSBFS_BATCH;
+        int count = std::min(MSBFS_BATCH,
+                             (int)sources.size() - batch * MSBFS_BATCH);
+
+        graph.multiSourceDist(first, count, state[worker],
+            [&](int k, int node, int dist) {
+                dist_graph.set(first[k], node, dist);
+                max_dist[worker] = std::max(max_dist[worker], dist);
+            });
+    });
+
+    // pick the element width from the diameter
+    dist_graph.narrow(*std::max_element(max_dist.begin(), max_dist.end()));
+
+    if (dist_transposed) {
+        dist_graph.buildTransposed();
+    }
+}
+
+inline int solver::roadDist(int src, int dst) {
+    return dist_labels.isBuilt()? dist_labels.get(src, dst):
+                                  dist_graph.get(src, dst);
+}
+
+int solver::queryDist(int src, int dst) {
+    int dist;
+
+    if (!query_cache.lookup(src, dst, graph.getEpoch(), &dist)) {
+        dist = hot_dist.dist(src, dst);
+        query_cache.store(src, dst, graph.getEpoch(), dist);
+    }
+
+    return dist;
+}
+
+int solver::findUber(int src) {
+    int best = -1;
+
+    if (!driver_table.getOnline()) {
+        return -1;
+    }
+
+    // few drivers: one pass over all of them costs less than a search
+    if ((long long)driver_table.getOnline() * driver_table.getOnline() <=
+        (long long)DISPATCH_SCAN_FACTOR * graph.getSize()) {
+        dispatch_scanned += driver_table.getOnline();
+        return dist_labels.isBuilt()? driver_table.nearest(dist_labels, src):
+                                      driver_table.nearest(dist_graph, src);
+    }
+
+    // the closest online drivers win, the best rated among them
+    graph.reverseLevels(src, [&](const std::vector<int>& nodes, int) {
+        for (auto node = nodes.begin(); node != nodes.end(); ++node) {
+            const std::vector<int>& here = driver_table.driversAt(*node);
+
+            dispatch_scanned += here.size();
+            for (auto it = here.begin(); it != here.end(); ++it) {
+                if (best == -1 || comp_rating(drivers[best], drivers[*it])) {
+                    best = *it;
+                }
+            }
+        }
+
+        return best != -1;
+    });
+
+    return best;
+}
+
+void solver::addRoad(int src, int dst, int weight) {
+    if (graph.addEdge(src, dst, weight)) {
+        reach_index.clear();
+        hot_dist.edgeAdded(src, dst);
+    }
+}
+
+void solver::removeRoad(int src, int dst) {
+    if (graph.removeEdge(src, dst)) {
+        reach_index.clear();
+        hot_dist.edgeRemoved(src, dst);
+    }
+}
+
+void solver::printTop(RankingTree<Driver>& ranking, TopLine& top, int k,
+                      void (*format)(std::string&, const Driver&),
+                      OutputWriter& fout) {
+    int valid;
+
+    k = (k < ranking.getSize())? k: ranking.getSize();
+    if (k < 0) {
+        k = 0;
+    }
+
+    // the entries ranked before the first change are still right
+    valid = (ranking.getChanged() < (int)top.ends.size())?
+             ranking.getChanged(): top.ends.size();
+
+    if (valid < k) {
+        top.ends.resize(valid);
+        top.line.resize(valid? top.ends.back(): 0);
+
+        ranking.visitRange(valid, k, [&](const Driver& driver) {
+            format(top.line, driver);
+            top.ends.push_back(top.line.size());
+        });
+        ranking.clearChanged();
+    }
+
+    if (k) {
+        fout << std::string_view(top.line.data(), top.ends[k - 1]);
+    }
+    fout << '\n';
+}
+
+bool solver::saveSnapshot(const char *path) {
+    std::vector<int> offsets, targets, weights;
+    std::vector<std::string_view> node_names(graph.getSize());
+
+    graph.exportCSR(offsets, targets, weights);
+    for (int i = 0; i < graph.getSize(); ++i) {
+        node_names[i] = names.name(graph.getInfo(i));
+    }
+
+    return Snapshot::save(path, offsets, targets, weights, node_names,
+                          dist_graph);
+}
+
+bool solver::loadSnapshot(const char *path) {
+    int n, id;
+
+    if (!snapshot.open(path)) {
+        return false;
+    }
+
+    n = snapshot.getNodes();
+    graph.loadCSR(n, snapshot.getOffsets(), snapshot.getTargets(),
+                  snapshot.getWeights());
+    reach_index.clear();
+
+    for (int i = 0; i < n; ++i) {
+        id = names.add(snapshot.getName(i));
+        graph.addInfo(i, id);
+        hash_graph.set(names.name(id), i);
+    }
+
+    hot_dist.reset();
+    driver_table.reset(n);
+
+    dist_graph.attach(snapshot.getDist(), n, snapshot.getDistWidth());
+    if (dist_transposed) {
+        dist_graph.buildTransposed();
+    }
+
+    return true;
 }
 
-solver::solver(): dist_graph(),
-    hash_graph(PRIME_CAPACITY_FOR_HASH, string_hash), graph(0),
-	hash_driver(PRIME_CAPACITY_FOR_HASH, string_hash), drivers(),
-	rating_top(comp_rating), races_top(comp_races), dist_top(comp_dist) {}
+InputReader& solver::reader(std::istream& fin) {
+    if (!input || input_stream != &fin) {
+        input = std::make_unique<InputReader>(fin);
+        input_stream = &fin;
+    }
 
-solver::~solver() {}
+    return *input;
+}
 
 void solver::task1_solver(std::ifstream& fin, std::ofstream& fout) {
-    int i, n, m, src, dst, q1;
-	std::string str;
+    OutputWriter writer(fout);
+
+    if (snapshot_load_path.empty()) {
+        task1_solver(reader(fin), writer);
+    } else if (!loadSnapshot(snapshot_load_path.c_str())) {
+        std::cout << "Failed to load snapshot!\n";
+        exit(1);
+    }
+}
+
+void solver::task2_solver(std::ifstream& fin, std::ofstream& fout) {
+    OutputWriter writer(fout);
+
+    if (snapshot_load_path.empty()) {
+        task2_solver(reader(fin), writer);
+    }
+}
+
+void solver::task3_solver(std::ifstream& fin, std::ofstream& fout) {
+    OutputWriter writer(fout);
+
+    if (!snapshot_load_path.empty()) {
+        return;
+    }
+
+    task3_solver(reader(fin), writer);
 
+    if (!snapshot_save_path.empty() &&
+        !saveSnapshot(snapshot_save_path.c_str())) {
+        std::cout << "Failed to save snapshot!\n";
+    }
+}
+
+void solver::task4_solver(std::ifstream& fin, std::ofstream& fout) {
+    OutputWriter writer(fout);
+
+    task4_solver(reader(fin), writer);
+}
+
+void solver::task5_solver(std::ifstream& fin, std::ofstream& fout) {
+    OutputWriter writer(fout);
+
+    task5_solver(reader(fin), writer);
+}
+
+void solver::task1_solver(InputReader& fin, OutputWriter& fout) {
+    int i, n, m, src, dst, q1, id, weight = 1, known;
+	std::string_view str;
+    bool weighted;
+
+    // roads weigh 1 unless the header says they all give their length
+    weighted = fin.accept(WEIGHTED_MAP_HEADER);
 	fin >> n >> m;
 	graph.setSize(n);
-    dist_graph = std::vector<std::vector<int>>(n);
 
 	for (i = 0; i < n; ++i) {
 		fin >> str;
-        graph.addInfo(i, str);
-		hash_graph.set(str, i);
+        id = names.add(str);
+        graph.addInfo(i, id);
+		hash_graph.set(names.name(id), i);
 	}
 
 	for (i = 0; i < m; ++i) {
@@ -109,9 +470,19 @@ void solver::task1_solver(std::ifstream& fin, std::ofstream& fout) {
 		fin >> str;
 		dst = hash_graph[str];
 
-		graph.addEdge(src, dst);
+        if (weighted) {
+            fin >> weight;
+        }
+
+		graph.addEdge(src, dst, std::max(weight, 1));
 	}
 
+    // the map is loaded, switch BFS to the contiguous adjacency
+    graph.freeze();
+    buildReachIndex(graph, reach_index);
+    hot_dist.reset();
+    driver_table.reset(n);
+
     fin >> q1;
 
     for (i = 0; i < q1; ++i) {
@@ -120,13 +491,18 @@ void solver::task1_solver(std::ifstream& fin, std::ofstream& fout) {
         fin >> str;
         dst = hash_graph[str];
 
-        fout << (graph.pathFrom(src, dst)? "y\n": "n\n");
+        known = reach_index.reaches(src, dst);
+        if (known == -1) {
+            known = graph.pathFrom(src, dst);
+        }
+
+        fout << (known? "y\n": "n\n");
     }
 }
 
-void solver::task2_solver(std::ifstream& fin, std::ofstream& fout) {
+void solver::task2_solver(InputReader& fin, OutputWriter& fout) {
 	int i, src, dst, q2;
-    std::string str;
+    std::string_view str;
 
     fin >> q2;
 
@@ -136,14 +512,14 @@ void solver::task2_solver(std::ifstream& fin, std::ofstream& fout) {
         fin >> str;
         dst = hash_graph[str];
 
-        fout << graph.distFrom(src, dst) << '\n';
+        fout << queryDist(src, dst) << '\n';
     }
 }
 
-void solver::task3_solver(std::ifstream& fin, std::ofstream& fout) {
+void solver::task3_solver(InputReader& fin, OutputWriter& fout) {
 	int i, q3, type, a, b, c, dist_ac, dist_cb;
     bool edge_ab, edge_ba;
-    std::string str;
+    std::string_view str;
     char q_type;
 
     fin >> q3;
@@ -161,44 +537,45 @@ void solver::task3_solver(std::ifstream& fin, std::ofstream& fout) {
         if (q_type == 'c') {
             switch (type) {
                 case 0:
-                    graph.addEdge(a, b);
+                    addRoad(a, b, 1);
                     break;
                 case 1:
-                    graph.removeEdge(a, b);
-                    graph.removeEdge(b, a);
+                    removeRoad(a, b);
+                    removeRoad(b, a);
                     break;
                 case 2:
-                    graph.addEdge(a, b);
-                    graph.addEdge(b, a);
+                    addRoad(a, b, 1);
+                    addRoad(b, a, 1);
                     break;
                 default:
                     edge_ab = graph.hasEdge(a, b);
                     edge_ba = graph.hasEdge(b, a);
 
+                    // a reversed road keeps its length
                     if (edge_ab && !edge_ba) {
-                        graph.addEdge(b, a);
-                        graph.removeEdge(a, b);
+                        addRoad(b, a, graph.getWeight(a, b));
+                        removeRoad(a, b);
                     }
 
                     if (!edge_ab && edge_ba) {
-                        graph.addEdge(a, b);
-                        graph.removeEdge(b, a);
+                        addRoad(a, b, graph.getWeight(b, a));
+                        removeRoad(b, a);
                     }
             }
         } else {
             switch (type) {
                 case 0:
-                    fout << (graph.pathFrom(a, b)? "y\n": "n\n");
+                    fout << (queryDist(a, b) != -1? "y\n": "n\n");
                     break;
                 case 1:
-                    fout << graph.distFrom(a, b) << '\n';
+                    fout << queryDist(a, b) << '\n';
                     break;
                 default:
                     fin >> str;
                     c = hash_graph[str];
 
-                    dist_ac = graph.distFrom(a, c);
-                    dist_cb = graph.distFrom(c, b);
+                    dist_ac = queryDist(a, c);
+                    dist_cb = queryDist(c, b);
 
                     if (dist_ac != -1 && dist_cb != -1) {
                         fout << dist_ac + dist_cb << '\n';
@@ -209,16 +586,13 @@ void solver::task3_solver(std::ifstream& fin, std::ofstream& fout) {
         }
     }
 
-    for (i = 0; i < graph.getSize(); ++i) {
-        dist_graph[i] = graph.getDistNodes(i);
-    }
+    computeDistGraph();
 }
 
-void solver::task4_solver(std::ifstream& fin, std::ofstream& fout) {
-	int i, k, q3, src, dst, index_driver, node, index_uber, nr_drivers;
+void solver::task4_solver(InputReader& fin, OutputWriter& fout) {
+	int i, q3, src, dst, index_driver, node, index_uber, nr_drivers;
     std::vector<int> neighbors_dst;
-    std::list<Driver> list_top;
-    std::string str1, str2;
+    std::string_view str1, str2;
     Driver new_driver;
     double rating;
 
@@ -228,6 +602,8 @@ void solver::task4_solver(std::ifstream& fin, std::ofstream& fout) {
         fin >> str1;
 
         if (str1 == "d") {
+            ScopedLatency timer(eventLatency(EVENT_DRIVER));
+
             // read driver and location names
             fin >> str1 >> str2;
 
@@ -237,69 +613,62 @@ void solver::task4_solver(std::ifstream& fin, std::ofstream& fout) {
             if (hash_driver.lookup(str1)) {
                 index_driver = hash_driver[str1];
 
-                drivers[index_driver].status = Driver::Status::ON;
                 drivers[index_driver].node = node;
+                driver_table.setOnline(index_driver, node);
             } else {
-                hash_driver.set(str1, drivers.size());
-
                 new_driver.id = drivers.size();
-                new_driver.name = str1;
-                new_driver.status = Driver::Status::ON;
+                new_driver.name = names.name(names.add(str1));
+
+                hash_driver.set(new_driver.name, new_driver.id);
                 new_driver.node = node;
                 new_driver.rating = 0;
                 new_driver.nr_races = 0;
                 new_driver.dist = 0;
 
                 drivers.push_back(new_driver);
+                driver_table.addDriver(new_driver.id, new_driver.name);
+                driver_table.setOnline(new_driver.id, node);
 
-                rating_top.insertInOrder(new_driver);
-        		races_top.insertInOrder(new_driver);
-        		dist_top.insertInOrder(new_driver);
+                rating_top.insert(new_driver.id, new_driver);
+                races_top.insert(new_driver.id, new_driver);
+                dist_top.insert(new_driver.id, new_driver);
             }
         } else if (str1 == "b") {
+            ScopedLatency timer(eventLatency(EVENT_BREAK));
+
             // read driver name
             fin >> str1;
 
             index_driver = hash_driver[str1];
-            drivers[index_driver].status = Driver::Status::OFF;
+            driver_table.setOffline(index_driver);
         } else if (str1 == "r") {
+            ScopedLatency timer(eventLatency(EVENT_RIDE));
+
             // read start and end locations names; rating given by client
             fin >> str1 >> str2 >> rating;
 
-            if (!drivers.size()) {
-                fout << "Soferi indisponibili\n";
-                continue;
-            }
-
             src = hash_graph[str1];
             dst = hash_graph[str2];
 
-            index_uber = 0;
-            for (unsigned int j = 1; j < drivers.size(); ++j) {
-                if (comp_uber(drivers[index_uber], drivers[j],
-                    src, dist_graph)) {
-                    index_uber = j;
-                }
-            }
+            index_uber = findUber(src);
 
-            if (drivers[index_uber].status == Driver::Status::OFF ||
-                dist_graph[drivers[index_uber].node][src] == -1) {
+            if (index_uber == -1) {
                 fout << "Soferi indisponibili\n";
                 continue;
             }
 
-            if (dist_graph[src][dst] == -1) {  // Can't access destination
+            if (roadDist(src, dst) == -1) {  // Can't access destination
                 neighbors_dst = graph.getNeighbors(dst);
 
                 for (unsigned int j = 0; j < neighbors_dst.size(); ++j) {
-                    if (dist_graph[src][neighbors_dst[j]] != -1) {
+                    if (roadDist(src, neighbors_dst[j]) != -1) {
                         dst = neighbors_dst[j];
                         break;
                     }
                 }
             }
 
-            if (dist_graph[src][dst] == -1) {
+            if (roadDist(src, dst) == -1) {
                 fout << "Destinatie inaccesibila\n";
                 continue;
             }
@@ -308,62 +677,34 @@ void solver::task4_solver(std::ifstream& fin, std::ofstream& fout) {
             drivers[index_uber].nr_races++;
 
             drivers[index_uber].dist +=
-            dist_graph[drivers[index_uber].node][src] + dist_graph[src][dst];
+            roadDist(drivers[index_uber].node, src) + roadDist(src, dst);
 
             drivers[index_uber].node = dst;
+            driver_table.setOnline(index_uber, dst);
+            driver_table.setRating(index_uber, drivers[index_uber].rating,
+                                   drivers[index_uber].nr_races);
 
-            rating_top.remove(drivers[index_uber]);
-        	races_top.remove(drivers[index_uber]);
-        	dist_top.remove(drivers[index_uber]);
-
-            rating_top.insertInOrder(drivers[index_uber]);
-        	races_top.insertInOrder(drivers[index_uber]);
-        	dist_top.insertInOrder(drivers[index_uber]);
+            rating_top.update(index_uber, drivers[index_uber]);
+            races_top.update(index_uber, drivers[index_uber]);
+            dist_top.update(index_uber, drivers[index_uber]);
         } else if (str1 == "top_rating") {
-            fin >> nr_drivers;
-
-            nr_drivers = (nr_drivers < rating_top.getSize())?
-                          nr_drivers: rating_top.getSize();
+            ScopedLatency timer(eventLatency(EVENT_TOP_RATING));
 
-            k = 0;
-            list_top = rating_top.getList();
-            for (auto it = list_top.begin();
-                it != list_top.end() && k < nr_drivers; ++it, ++k) {
-            	rating = ((*it).nr_races? (*it).rating / (*it).nr_races: 0.0);
-
-                fout << (*it).name << ':'
-                     << std::fixed << std::setprecision(3) << rating << ' ';
-            }
-            fout << '\n';
-        } else if (str1 == "top_dist") {
             fin >> nr_drivers;
+            printTop(rating_top, rating_line, nr_drivers, format_rating, fout);
+        } else if (str1 == "top_dist") {
+            ScopedLatency timer(eventLatency(EVENT_TOP_DIST));
 
-            nr_drivers = (nr_drivers < dist_top.getSize())?
-                          nr_drivers: dist_top.getSize();
-
-            k = 0;
-            list_top = dist_top.getList();
-            for (auto it = list_top.begin();
-                it != list_top.end() && k < nr_drivers; ++it, ++k) {
-                fout << (*it).name << ':'
-                     << (*it).dist << ' ';
-            }
-            fout << '\n';
-        } else if (str1 == "top_rides") {
             fin >> nr_drivers;
+            printTop(dist_top, dist_line, nr_drivers, format_dist, fout);
+        } else if (str1 == "top_rides") {
+            ScopedLatency timer(eventLatency(EVENT_TOP_RIDES));
 
-            nr_drivers = (nr_drivers < races_top.getSize())?
-                          nr_drivers: races_top.getSize();
-
-            k = 0;
-            list_top = races_top.getList();
-            for (auto it = list_top.begin();
-                it != list_top.end() && k < nr_drivers; ++it, ++k) {
-                fout << (*it).name << ':'
-                     << (*it).nr_races << ' ';
-            }
-            fout << '\n';
+            fin >> nr_drivers;
+            printTop(races_top, races_line, nr_drivers, format_races, fout);
         } else {
+            ScopedLatency timer(eventLatency(EVENT_INFO));
+
             // read driver name
             fin >> str1;
 
@@ -373,61 +714,111 @@ void solver::task4_solver(std::ifstream& fin, std::ofstream& fout) {
                       drivers[index_driver].nr_races: 0.0);
 
             fout << str1 << ": "
-                 << graph.getInfo(drivers[index_driver].node) << ' '
-                 << std::fixed << std::setprecision(3) << rating << ' '
+                 << names.name(graph.getInfo(drivers[index_driver].node))
+                 << ' '
+                 << Fixed{rating, 3} << ' '
                  << drivers[index_driver].nr_races << ' '
                  << drivers[index_driver].dist << ' '
-                 << (drivers[index_driver].status? "online\n": "offline\n");
+                 << (driver_table.isOnline(index_driver)? "online\n":
+                                                          "offline\n");
         }
     }
 }
 
-void solver::task5_solver(std::ifstream& fin, std::ofstream& fout) {
-	int i, j, nr_intersections, combustible, index_driver, src, dst, distance;
-	std::vector<int> dist_comb(graph.getSize(), INF),
-                     nodes_perm(graph.getSize());
-	std::string str;
+void solver::fuelRange(const std::vector<FuelQuery>& queries,
+                       std::vector<std::vector<int>>& answers) {
+    // as many stamp arrays as parallel_for starts workers
+    std::vector<std::vector<int>> seen(std::max(std::min(nr_threads,
+                                                         (int)queries.size()),
+                                                1));
+
+    answers.assign(queries.size(), std::vector<int>());
+
+    parallel_for(0, (int)queries.size(), 1, nr_threads, [&](int worker, int q) {
+        const FuelQuery& query = queries[q];
+        std::vector<int>& stamp = seen[worker];
+        std::vector<std::pair<int, int>> kept, sorted;  // (distance, node)
+        std::vector<int> bucket;
+        unsigned int first, last;
+        int max_dist = 0, distance;
+
+        if (stamp.empty()) {
+            stamp.assign(graph.getSize(), -1);
+        }
+
+        // the candidates in range, each node once
+        for (auto it = query.candidates.begin();
+             it != query.candidates.end(); ++it) {
+            distance = roadDist(query.src, *it);
 
-	fin >> combustible >> str;
-	index_driver = hash_driver[str];
-	src = drivers[index_driver].node;
+            if (stamp[*it] != q && distance != -1 && distance <= query.fuel) {
+                stamp[*it] = q;
+                kept.push_back(std::make_pair(distance, *it));
+                max_dist = std::max(max_dist, distance);
+            }
+        }
 
-	fin >> nr_intersections;
+        // bucket by distance when the buckets are few, sort otherwise
+        if (max_dist < 2 * (int)kept.size()) {
+            bucket.assign(max_dist + 2, 0);
+            for (auto it = kept.begin(); it != kept.end(); ++it) {
+                bucket[it->first + 1]++;
+            }
+            for (int d = 0; d <= max_dist; ++d) {
+                bucket[d + 1] += bucket[d];
+            }
 
-	for (i = 0; i < nr_intersections; ++i) {
-		fin >> str;
-		dst = hash_graph[str];
-		distance = dist_graph[src][dst];
+            sorted.resize(kept.size());
+            for (auto it = kept.begin(); it != kept.end(); ++it) {
+                sorted[bucket[it->first]++] = *it;
+            }
+        } else {
+            sorted.swap(kept);
+            std::sort(sorted.begin(), sorted.end());
+        }
 
-		if (distance != -1 && distance <= combustible) {
-			dist_comb[dst] = distance;
-		}
-	}
+        // then by name inside every distance
+        for (first = 0; first < sorted.size(); first = last) {
+            last = first + 1;
+            while (last < sorted.size() &&
+                   sorted[last].first == sorted[first].first) {
+                last++;
+            }
 
-	for (i = 0; i < graph.getSize(); ++i) {
-		nodes_perm[i] = i;
-	}
+            std::sort(sorted.begin() + first, sorted.begin() + last,
+                      [&](const std::pair<int, int>& a,
+                          const std::pair<int, int>& b) {
+                          return names.name(graph.getInfo(a.second)) <
+                                 names.name(graph.getInfo(b.second));
+                      });
+        }
 
-	for (i = 0; i < graph.getSize(); ++i) {
-		for (j = i + 1; j < graph.getSize(); ++j) {
-			if (dist_comb[i] > dist_comb[j]) {
-				swap(dist_comb[i], dist_comb[j]);
-				swap(nodes_perm[i], nodes_perm[j]);
-			}
-
-			if (dist_comb[i] == dist_comb[j] &&
-                graph.getInfo(nodes_perm[i]) > graph.getInfo(nodes_perm[j])) {
-				swap(dist_comb[i], dist_comb[j]);
-				swap(nodes_perm[i], nodes_perm[j]);
-			}
-		}
-	}
+        for (auto it = sorted.begin(); it != sorted.end(); ++it) {
+            answers[q].push_back(it->second);
+        }
+    });
+}
 
-	for (i = 0; i < graph.getSize(); ++i) {
-		if (dist_comb[i] != INF) {
-			fout << graph.getInfo(nodes_perm[i]) << ' ';
-		} else {
-			break;
-		}
-	}
+void solver::task5_solver(InputReader& fin, OutputWriter& fout) {
+    int i, nr_intersections;
+    std::vector<FuelQuery> queries(1);
+    std::vector<std::vector<int>> answers;
+    std::string_view str;
+
+    fin >> queries[0].fuel >> str;
+    queries[0].src = drivers[hash_driver[str]].node;
+
+    fin >> nr_intersections;
+
+    queries[0].candidates.resize(nr_intersections);
+    for (i = 0; i < nr_intersections; ++i) {
+        fin >> str;
+        queries[0].candidates[i] = hash_graph[str];
+    }
+
+    fuelRange(queries, answers);
+
+    for (auto it = answers[0].begin(); it != answers[0].end(); ++it) {
+        fout << names.name(graph.getInfo(*it)) << ' ';
+    }
 }
@@ -4,25 +4,48 @@
 #define SOLVER_H_
 
 #include <fstream>
+#include <memory>
 #include <utility>
 #include <iomanip>
 #include <string>
 #include <vector>
 #include <list>
-#include "./sorted_list.h"
+#include "./ranking_tree.h"
 #include "./list_graph.h"
 #include "./hashtable.h"
+#include "./flat_map.h"
 #include "./hash_functions.h"
-#define INF 1e6
-
-template <class T>
-void swap(T&, T&);
+#include "./parallel_for.h"
+#include "./dist_matrix.h"
+#include "./reach_index.h"
+#include "./hub_labels.h"
+#include "./dynamic_dist.h"
+#include "./query_cache.h"
+#include "./driver_table.h"
+#include "./name_pool.h"
+#include "./input_reader.h"
+#include "./output_writer.h"
+#include "./latency_histogram.h"
+#include "./snapshot.h"
+// distance rows kept up to date through task3 road changes
+#define HOT_DIST_ROWS 64
+// queries from one source before it gets a row
+#define HOT_DIST_AFTER 2
+// slots of the task2/task3 query result cache
+#define QUERY_CACHE_SLOTS 4096
+// dispatch scans every online driver while online^2 <= this * intersections,
+// and searches outward from the client otherwise
+#define DISPATCH_SCAN_FACTOR 16
+// first token of a map whose roads all give their length ("A B 7")
+#define WEIGHTED_MAP_HEADER "weighted"
+// largest distance matrix kept, in bytes at the width the diameter bound
+// asks for; bigger maps get hub labels instead
+#define DIST_MATRIX_MAX_BYTES (1ull << 30)
 
 class Driver {
  public:
     int id;
-    std::string name;
-    enum Status {OFF = false, ON = true} status;
+    std::string_view name;  // stored in the solver's NamePool
     double rating;
     int node, nr_races, dist;
 
@@ -36,28 +59,184 @@ bool comp_rating(const Driver &, const Driver &);
 bool comp_races(const Driver &, const Driver &);
 // @return True if lhs < rhs, False otherwise
 bool comp_dist(const Driver &, const Driver &);
-// @return True if lhs < rhs, False otherwise
-bool comp_uber(const Driver &, const Driver &,
-    int, const std::vector<std::vector<int>> &);
+
+// Appends the leaderboard entry "name:value " of a driver to a line
+void format_rating(std::string&, const Driver&);
+void format_races(std::string&, const Driver&);
+void format_dist(std::string&, const Driver&);
+
+/**
+ * Pre-formatted leaderboard line of a ranking. ends[k - 1] is where the
+ * k-th entry stops, so any shorter top is a prefix of the line.
+ */
+struct TopLine {
+    std::string line;
+    std::vector<size_t> ends;
+};
+
+// Task4 event types, timed apart when stats are on
+enum Task4Event {EVENT_DRIVER, EVENT_BREAK, EVENT_RIDE, EVENT_TOP_RATING,
+                 EVENT_TOP_DIST, EVENT_TOP_RIDES, EVENT_INFO, TASK4_EVENTS};
+
+// A task5 query: the intersections a driver may go to with its fuel
+struct FuelQuery {
+    int src;
+    int fuel;
+    std::vector<int> candidates;
+};
 
 class solver {
  private:
-    std::vector<std::vector<int>> dist_graph;
-    Hashtable<std::string, int> hash_graph;
-    ListGraph<std::string> graph;
-
-    Hashtable<std::string, int> hash_driver;
+    // mapped city of loadSnapshot; dist_graph reads its matrix in place
+    Snapshot snapshot;
+    DistMatrix dist_graph;
+    // answer in place of dist_graph when built, for maps too big for it
+    HubLabels dist_labels;
+    // every intersection and driver name; the structures below keep ids
+    // (graph info) or views (map keys, Driver::name) into it
+    NamePool names;
+
+    FlatMap<std::string_view, int> hash_graph;
+    ListGraph<int> graph;
+    // answers task1 path queries; cleared by the first road change
+    ReachIndex reach_index;
+    DynamicDist<ListGraph<int>> hot_dist;
+    QueryCache query_cache;
+
+    FlatMap<std::string_view, int> hash_driver;
     std::vector<Driver> drivers;
+    DriverTable driver_table;
+
+    RankingTree<Driver> rating_top;
+    RankingTree<Driver> races_top;
+    RankingTree<Driver> dist_top;
+
+    TopLine rating_line;
+    TopLine races_line;
+    TopLine dist_line;
+
+    // number of threads used to precompute the distance matrix
+    int nr_threads;
+
+    // keep a column-major copy of the distance matrix for dispatch
+    bool dist_transposed;
+
+    // build hub labels instead of the distance matrix, whatever the size
+    bool dist_by_labels;
+
+    // time task4 events and dump counters at exit
+    bool stats;
+    LatencyHistogram event_latency[TASK4_EVENTS];
+    long long dispatch_scanned;  // drivers looked at by dispatch
+
+    // the input of the stream task functions, read whole by the first one
+    std::unique_ptr<InputReader> input;
+    const std::istream *input_stream;
+
+    // snapshot loaded in place of tasks 1 to 3 ($UBER_SNAPSHOT) and the
+    // one saved after task3 ($UBER_SAVE_SNAPSHOT); empty if none
+    std::string snapshot_load_path;
+    std::string snapshot_save_path;
+
+    // Return the reader over a stream, made on first use
+    InputReader& reader(std::istream&);
+
+    // Fills dist_graph from the hot rows, then multi-source BFS batches
+    // (one Dial search each on a weighted map) for the other sources, spread
+    // over nr_threads; or builds dist_labels, if the matrix would be over
+    // DIST_MATRIX_MAX_BYTES or dist_by_labels is set
+    void computeDistGraph();
+
+    // Return distance between two nodes for task4/task5, from dist_labels
+    // if they are built, from dist_graph otherwise
+    inline int roadDist(int, int);
+
+    // Return distance between two nodes for task2/task3 queries, cached
+    int queryDist(int, int);
+
+    // Return the driver sent to a client at the given node, -1 if none
+    int findUber(int);
+
+    // Return the histogram of an event type, nullptr if stats are off
+    LatencyHistogram *eventLatency(Task4Event);
+
+    // Writes the first k drivers of a ranking; the cached line is only
+    // rebuilt from the first rank that changed since it was formatted
+    void printTop(RankingTree<Driver>&, TopLine&, int,
+                  void (*)(std::string&, const Driver&), OutputWriter&);
 
-    SortedList<Driver> rating_top;
-    SortedList<Driver> races_top;
-    SortedList<Driver> dist_top;
+    // Adds (with its length) / removes a road, keeping the hot rows up to date
+    void addRoad(int, int, int);
+    void removeRoad(int, int);
 
  public:
     solver();
 
     ~solver();
 
+    // Sets the number of threads; default is $UBER_THREADS or the cores
+    void setThreads(int);
+
+    // Enables the column-major distance copy; default is $UBER_DIST_COLUMNS
+    void setTransposedDist(bool);
+
+    // Uses hub labels for the task4/task5 distances even when the matrix
+    // would fit; default is $UBER_DIST_LABELS
+    void setDistLabels(bool);
+
+    // Enables task4 latency histograms and counters, dumped to stderr at
+    // exit; default is $UBER_STATS
+    void setStats(bool);
+
+    /**
+     * Answers a batch of task5 queries, spread over nr_threads. The
+     * candidates within fuel of src (each one once) are bucketed by
+     * distance and every bucket is sorted by name: O(k log k) in the
+     * number of candidates k of a query.
+     *
+     * @param answers Filled with, for each query, its candidates in range
+     *                by distance, then by name.
+     */
+    void fuelRange(const std::vector<FuelQuery>& queries,
+                   std::vector<std::vector<int>>& answers);
+
+    /**
+     * Writes the city as task3 left it (roads, intersection names and the
+     * distance matrix) to a snapshot file.
+     *
+     * @return True if the file was written, False otherwise (also when
+     * the distances are kept as hub labels, not as a matrix).
+     */
+    bool saveSnapshot(const char *path);
+
+    /**
+     * Loads a city saved by saveSnapshot, in place of tasks 1 to 3 on a
+     * new solver; task4 can follow right away. The file stays mapped and
+     * the distance matrix is read from it, not copied. The graph is still
+     * rebuilt from the mapped CSR arrays (ListGraph::loadCSR, O(V + E)) and
+     * every name goes back into hash_graph (O(V)): parsing and the V^2
+     * matrix are skipped, the linear part is not.
+     *
+     * @return True if the snapshot was loaded, False if the file is not a
+     * valid snapshot (then the solver is unchanged).
+     */
+    bool loadSnapshot(const char *path);
+
+    void task1_solver(InputReader&, OutputWriter&);
+
+    void task2_solver(InputReader&, OutputWriter&);
+
+    void task3_solver(InputReader&, OutputWriter&);
+
+    void task4_solver(InputReader&, OutputWriter&);
+
+    void task5_solver(InputReader&, OutputWriter&);
+
+    // The same tasks over streams: the first call maps (or reads) the rest
+    // of fin into an InputReader that the next calls go on with, and
+    // answers are buffered by an OutputWriter. With $UBER_SNAPSHOT set,
+    // tasks 1 to 3 load that snapshot instead of reading fin; with
+    // $UBER_SAVE_SNAPSHOT set, task3 saves the city there once done.
     void task1_solver(std::ifstream&, std::ofstream&);
 
     void task2_solver(std::ifstream&, std::ofstream&);
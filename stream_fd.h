@@ -0,0 +1,38 @@
+// Copyright 2019 Nedelcu Horia (nedelcu.horia.alexandru@gmail.com)
+
+/**
+ * stream_fd.h
+ */
+
+#ifndef STREAM_FD_H_
+#define STREAM_FD_H_
+
+#include <fstream>
+#include <ios>
+
+/**
+ * Gets the file descriptor under a file stream, so the file can be read
+ * or written without going through the stream. Only libstdc++ exposes it
+ * (as the protected _M_file of std::filebuf, reached here through a
+ * pointer to member of a derived class).
+ *
+ * @param stream A stream; only an open std::filebuf under it has one.
+ * @return the descriptor, still owned by the stream; -1 if there is none.
+ */
+inline int streamFd(std::ios& stream) {
+#ifdef __GLIBCXX__
+    struct Access : std::filebuf {
+        static int fd(std::filebuf *buf) {
+            return (buf->*(&Access::_M_file)).fd();
+        }
+    };
+    std::filebuf *buf = dynamic_cast<std::filebuf *>(stream.rdbuf());
+
+    return buf && buf->is_open()? Access::fd(buf): -1;
+#else
+    (void)stream;
+    return -1;
+#endif
+}
+
+#endif  // STREAM_FD_H_
@@ -0,0 +1,109 @@
+// Copyright 2019 Nedelcu Horia (nedelcu.horia.alexandru@gmail.com)
+
+/**
+ * dynamic_dist_test.cpp
+ *
+ * DynamicDist rows repaired over seeded road additions and removals,
+ * checked against a fresh BFS over a plain adjacency list after every
+ * change.
+ */
+
+#include <cstdio>
+#include <queue>
+#include <random>
+#include <vector>
+#include "../list_graph.h"
+#include "../dynamic_dist.h"
+
+// Return the BFS distances from src, -1 for the unreachable nodes
+std::vector<int> bfs(const std::vector<std::vector<int>>& adj, int src) {
+    std::vector<int> dist(adj.size(), -1);
+    std::queue<int> queue;
+
+    dist[src] = 0;
+    queue.push(src);
+    while (!queue.empty()) {
+        int node = queue.front();
+
+        queue.pop();
+        for (unsigned int i = 0; i < adj[node].size(); ++i) {
+            if (dist[adj[node][i]] == -1) {
+                dist[adj[node][i]] = dist[node] + 1;
+                queue.push(adj[node][i]);
+            }
+        }
+    }
+
+    return dist;
+}
+
+// Return the number of mismatches over one random graph and its changes
+int run(std::mt19937& rng, int n, int nr_edges, int capacity, int changes) {
+    ListGraph<int> graph(n);
+    DynamicDist<ListGraph<int>> hot(&graph, capacity, 1);
+    std::vector<std::vector<int>> adj(n);
+    int errors = 0;
+
+    for (int i = 0; i < nr_edges; ++i) {
+        int src = rng() % n, dst = rng() % n;
+
+        if (graph.addEdge(src, dst)) {
+            adj[src].push_back(dst);
+        }
+    }
+    graph.freeze();
+    hot.reset();
+
+    for (int step = 0; step < changes; ++step) {
+        int src = rng() % n, dst = rng() % n;
+
+        // remove an existing road about as often as a new one is added
+        if (rng() % 2 && !adj[src].empty()) {
+            int index = rng() % adj[src].size();
+
+            dst = adj[src][index];
+            adj[src].erase(adj[src].begin() + index);
+            graph.removeEdge(src, dst);
+            hot.edgeRemoved(src, dst);
+        } else if (graph.addEdge(src, dst)) {
+            adj[src].push_back(dst);
+            hot.edgeAdded(src, dst);
+        }
+
+        // queries make sources hot; the kept rows must match a fresh BFS
+        for (int query = 0; query < 3; ++query) {
+            int from = rng() % n, to = rng() % n;
+
+            errors += hot.dist(from, to) != bfs(adj, from)[to];
+        }
+        for (int node = 0; node < n; ++node) {
+            const std::vector<int> *row = hot.getRow(node);
+
+            if (row && *row != bfs(adj, node)) {
+                ++errors;
+            }
+        }
+    }
+
+    return errors;
+}
+
+int main() {
+    std::mt19937 rng(2019);
+    int errors = 0;
+
+    for (int round = 0; round < 200; ++round) {
+        int n = 2 + rng() % 60;
+
+        // sparse graphs break apart and join again; small capacities evict
+        errors += run(rng, n, rng() % (3 * n), 1 + rng() % 8, 60);
+    }
+
+    if (errors) {
+        printf("dynamic_dist_test: %d mismatches\n", errors);
+        return 1;
+    }
+
+    printf("dynamic_dist_test: OK\n");
+    return 0;
+}
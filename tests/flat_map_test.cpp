@@ -0,0 +1,87 @@
+// Copyright 2019 Nedelcu Horia (nedelcu.horia.alexandru@gmail.com)
+
+/**
+ * flat_map_test.cpp
+ *
+ * FlatMap under seeded set/remove churn, checked against
+ * std::unordered_map, with a good hash and with one that sends every key
+ * to a few groups (long probes, tombstones on the way).
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "../flat_map.h"
+#include "../hash_functions.h"
+
+// Return a hash that puts all the keys in 4 probe paths
+ULL crowded_hash(std::string_view key) {
+    return string_hash(key) & 3;
+}
+
+// Return the number of mismatches after a run of set/remove churn
+int churn(ULL (*hash)(std::string_view), unsigned int seed, int nr_keys,
+          int steps) {
+    std::mt19937 rng(seed);
+    FlatMap<std::string, int> map(1, hash);
+    std::unordered_map<std::string, int> expected;
+    int errors = 0, max_size = 0;
+
+    for (int step = 0; step < steps; ++step) {
+        std::string key = "Strada_" + std::to_string(rng() % nr_keys);
+        int value = rng();
+
+        // more removes than sets in the second half of every 1000 steps
+        if ((int)(rng() % 100) < ((step / 500) % 2? 60: 35)) {
+            map.remove(key);
+            expected.erase(key);
+        } else {
+            map.set(key, value);
+            expected[key] = value;
+        }
+
+        if (map.getSize() != (int)expected.size()) {
+            ++errors;
+        }
+        max_size = std::max(max_size, (int)expected.size());
+
+        if (step % 97 == 0) {
+            for (int i = 0; i < nr_keys; ++i) {
+                std::string other = "Strada_" + std::to_string(i);
+                auto it = expected.find(other);
+
+                if (map.lookup(other) != (it != expected.end()) ||
+                    map[other] != (it != expected.end()? it->second: 0)) {
+                    ++errors;
+                }
+            }
+        }
+    }
+
+    // tombstones are reused or cleared, so churn does not grow the map
+    if (map.getCapacity() > 4 * max_size + 4 * FLAT_MAP_GROUP) {
+        ++errors;
+    }
+
+    return errors;
+}
+
+int main() {
+    int errors = 0;
+
+    for (unsigned int seed = 1; seed <= 5; ++seed) {
+        errors += churn(string_hash, seed, 50 * seed, 20000);
+        errors += churn(crowded_hash, seed, 20 * seed, 5000);
+    }
+
+    if (errors) {
+        printf("flat_map_test: %d mismatches\n", errors);
+        return 1;
+    }
+
+    printf("flat_map_test: OK\n");
+    return 0;
+}
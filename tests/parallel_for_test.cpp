@@ -0,0 +1,72 @@
+// Copyright 2019 Nedelcu Horia (nedelcu.horia.alexandru@gmail.com)
+
+/**
+ * parallel_for_test.cpp
+ *
+ * parallel_for over ranges, chunks and thread counts: every index is
+ * visited once, worker ids stay below the number of chunks, and a range
+ * of a single chunk runs on the caller.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include "../parallel_for.h"
+
+// Return the number of mismatches of one parallel_for call
+int run(int begin, int end, int chunk, int nr_threads) {
+    std::vector<std::atomic<int>> visits(std::max(end - begin, 0));
+    std::atomic<int> max_worker(-1), off_caller(0);
+    std::thread::id caller = std::this_thread::get_id();
+    int chunks = (std::max(end - begin, 0) + chunk - 1) / chunk;
+    int errors = 0;
+
+    for (unsigned int i = 0; i < visits.size(); ++i) {
+        visits[i] = 0;
+    }
+
+    parallel_for(begin, end, chunk, nr_threads, [&](int worker, int index) {
+        int seen = max_worker.load();
+
+        visits[index - begin]++;
+        while (worker > seen && !max_worker.compare_exchange_weak(seen,
+                                                                  worker)) {
+        }
+        if (std::this_thread::get_id() != caller) {
+            off_caller++;
+        }
+    });
+
+    for (unsigned int i = 0; i < visits.size(); ++i) {
+        errors += visits[i] != 1;
+    }
+
+    // no more workers than chunks, and one chunk never leaves the caller
+    errors += max_worker >= std::max(std::min(nr_threads, chunks), 1);
+    errors += chunks <= 1 && off_caller != 0;
+
+    return errors;
+}
+
+int main() {
+    int errors = 0;
+
+    for (int threads = 1; threads <= 8; ++threads) {
+        for (int chunk = 1; chunk <= 5; ++chunk) {
+            for (int size = 0; size <= 40; ++size) {
+                errors += run(7, 7 + size, chunk, threads);
+            }
+        }
+    }
+    errors += run(0, 100000, 64, 4);
+
+    if (errors) {
+        printf("parallel_for_test: %d mismatches\n", errors);
+        return 1;
+    }
+
+    printf("parallel_for_test: OK\n");
+    return 0;
+}
@@ -0,0 +1,134 @@
+// Copyright 2019 Nedelcu Horia (nedelcu.horia.alexandru@gmail.com)
+
+/**
+ * ranking_tree_test.cpp
+ *
+ * RankingTree after random inserts, updates and removes, checked against
+ * a vector sorted the same way: rank, visitRange and getChanged.
+ */
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "../ranking_tree.h"
+
+struct Entry {
+    int key;
+    int id;
+};
+
+// @return True if lhs < rhs, False otherwise
+bool comp_entry(const Entry &lhs, const Entry &rhs) {
+    return lhs.key < rhs.key || (lhs.key == rhs.key && lhs.id < rhs.id);
+}
+
+// Return the entries in the tree's order, the largest first
+std::vector<Entry> sorted_entries(const std::vector<Entry>& entries,
+                                  const std::vector<bool>& present) {
+    std::vector<Entry> result;
+
+    for (unsigned int i = 0; i < entries.size(); ++i) {
+        if (present[i]) {
+            result.push_back(entries[i]);
+        }
+    }
+    std::sort(result.begin(), result.end(),
+              [](const Entry& a, const Entry& b) {
+                  return comp_entry(b, a);
+              });
+
+    return result;
+}
+
+// Return the first rank where the two orders differ
+int first_difference(const std::vector<Entry>& a,
+                     const std::vector<Entry>& b) {
+    unsigned int i = 0;
+
+    while (i < a.size() && i < b.size() && a[i].id == b[i].id) {
+        ++i;
+    }
+
+    return (a.size() == b.size() && i == a.size())? INT_MAX: i;
+}
+
+// Return the number of mismatches between the tree and the sorted vector
+int check(RankingTree<Entry>& tree, const std::vector<Entry>& expected) {
+    int errors = 0, first, last;
+    std::vector<Entry> visited;
+
+    if (tree.getSize() != (int)expected.size()) {
+        return 1;
+    }
+
+    for (unsigned int i = 0; i < expected.size(); ++i) {
+        errors += tree.rank(expected[i].id) != (int)i;
+    }
+
+    first = expected.size() / 3;
+    last = expected.size() - expected.size() / 4;
+    tree.visitRange(first, last, [&](const Entry& entry) {
+        visited.push_back(entry);
+    });
+    errors += visited.size() != (unsigned int)(last - first);
+    for (unsigned int i = 0; i < visited.size(); ++i) {
+        errors += visited[i].id != expected[first + i].id;
+    }
+
+    return errors;
+}
+
+int main() {
+    std::mt19937 rng(2019);
+    int errors = 0;
+
+    for (int round = 0; round < 50; ++round) {
+        int nr_ids = 1 + rng() % 300;
+        RankingTree<Entry> tree(comp_entry);
+        std::vector<Entry> entries(nr_ids);
+        std::vector<bool> present(nr_ids, false);
+        std::vector<Entry> before;
+
+        for (int id = 0; id < nr_ids; ++id) {
+            entries[id] = Entry{0, id};
+        }
+
+        for (int step = 0; step < 2000; ++step) {
+            int id = rng() % nr_ids, action = rng() % 4;
+
+            if (step % 100 == 0) {
+                tree.clearChanged();
+                before = sorted_entries(entries, present);
+            }
+
+            // few keys, so many entries tie on key and the ids decide
+            if (action == 0 && present[id]) {
+                tree.remove(id);
+                present[id] = false;
+            } else {
+                entries[id].key = rng() % 20;
+                tree.update(id, entries[id]);
+                present[id] = true;
+            }
+
+            std::vector<Entry> expected = sorted_entries(entries, present);
+
+            errors += check(tree, expected);
+            errors += first_difference(before, expected) < tree.getChanged();
+
+            if (tree.contains(id) != present[id]) {
+                ++errors;
+            }
+        }
+    }
+
+    if (errors) {
+        printf("ranking_tree_test: %d mismatches\n", errors);
+        return 1;
+    }
+
+    printf("ranking_tree_test: OK\n");
+    return 0;
+}
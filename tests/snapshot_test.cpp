@@ -0,0 +1,184 @@
+// Copyright 2019 Nedelcu Horia (nedelcu.horia.alexandru@gmail.com)
+
+/**
+ * snapshot_test.cpp
+ *
+ * A small city saved and mapped back, then the same file with one field
+ * broken at a time: every broken copy has to be rejected by open().
+ */
+
+#include <unistd.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../dist_matrix.h"
+#include "../snapshot.h"
+
+// byte offsets of the header fields the checks break
+#define HEADER_VERSION 8
+#define HEADER_DIST_WIDTH 20
+#define HEADER_WEIGHTED 24
+#define HEADER_SECTIONS 48
+// section numbers, in file order
+#define SECTION_OFFSETS 0
+#define SECTION_TARGETS 1
+#define SECTION_WEIGHTS 2
+#define SECTION_NAME_STARTS 3
+#define SECTION_NAMES 4
+
+// Return the whole content of a file
+std::string read_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+
+    return std::string(std::istreambuf_iterator<char>(in),
+                       std::istreambuf_iterator<char>());
+}
+
+// Replaces the content of a file
+void write_file(const std::string& path, const std::string& bytes) {
+    std::ofstream(path, std::ios::binary).write(bytes.data(), bytes.size());
+}
+
+// Overwrites the bytes of a value at an offset of a file image
+template <typename T>
+void poke(std::string& bytes, uint64_t offset, T value) {
+    std::memcpy(&bytes[offset], &value, sizeof(value));
+}
+
+// Return the file offset of a section, as the header stores it
+uint64_t section(const std::string& bytes, int index) {
+    uint64_t offset;
+
+    std::memcpy(&offset, &bytes[HEADER_SECTIONS + index * 8], sizeof(offset));
+    return offset;
+}
+
+// Return 1 if open() accepts a broken copy of a snapshot, 0 otherwise
+int accepted(const std::string& path, const std::string& bytes) {
+    Snapshot snapshot;
+
+    write_file(path, bytes);
+    return snapshot.open(path.c_str());
+}
+
+// Return the number of mismatches of a round trip and its broken copies
+int run(const std::string& path, bool weighted) {
+    // 0 -> 1 -> 2 -> 0, and 3 on its own
+    std::vector<int> offsets = {0, 1, 2, 3, 3};
+    std::vector<int> targets = {1, 2, 0};
+    std::vector<int> weights;
+    std::vector<std::string_view> names = {"Piata", "Gara", "Port", "Deal"};
+    DistMatrix dist;
+    Snapshot snapshot;
+    std::string bytes, broken;
+    int errors = 0;
+
+    if (weighted) {
+        weights = {2, 3, 4};
+    }
+
+    dist.reset(4, 9);
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            dist.set(i, j, (i == 3 || j == 3)? (i == j? 0: -1):
+                           (weighted? 3 * ((j - i + 3) % 3): (j - i + 3) % 3));
+        }
+    }
+
+    if (!Snapshot::save(path.c_str(), offsets, targets, weights, names,
+                        dist) || !snapshot.open(path.c_str())) {
+        return 1;
+    }
+
+    errors += snapshot.getNodes() != 4;
+    errors += !std::equal(offsets.begin(), offsets.end(),
+                          snapshot.getOffsets());
+    errors += !std::equal(targets.begin(), targets.end(),
+                          snapshot.getTargets());
+    errors += weighted? !snapshot.getWeights() ||
+                        !std::equal(weights.begin(), weights.end(),
+                                    snapshot.getWeights()):
+                        snapshot.getWeights() != nullptr;
+    for (int i = 0; i < 4; ++i) {
+        errors += snapshot.getName(i) != names[i];
+    }
+    errors += snapshot.getDistWidth() != dist.getWidth();
+    errors += std::memcmp(snapshot.getDist(), dist.getData(),
+                          dist.getBytes()) != 0;
+    snapshot.close();
+
+    bytes = read_file(path);
+
+    // a file cut anywhere short of its end
+    for (uint64_t size = 0; size < bytes.size(); size += 13) {
+        errors += accepted(path, bytes.substr(0, size));
+    }
+
+    broken = bytes;
+    broken[0] ^= 1;
+    errors += accepted(path, broken);
+
+    broken = bytes;
+    poke<uint32_t>(broken, HEADER_VERSION, SNAPSHOT_VERSION + 1);
+    errors += accepted(path, broken);
+
+    broken = bytes;
+    poke<int32_t>(broken, HEADER_DIST_WIDTH, 3);
+    errors += accepted(path, broken);
+
+    broken = bytes;
+    poke<int32_t>(broken, HEADER_WEIGHTED, 2);
+    errors += accepted(path, broken);
+
+    broken = bytes;
+    poke<uint64_t>(broken, HEADER_SECTIONS + SECTION_NAMES * 8,
+                   section(bytes, SECTION_NAMES) + 1);
+    errors += accepted(path, broken);
+
+    // a road to a node that does not exist
+    broken = bytes;
+    poke<int32_t>(broken, section(bytes, SECTION_TARGETS) + 4, 4);
+    errors += accepted(path, broken);
+
+    // a row that starts after the next one
+    broken = bytes;
+    poke<int32_t>(broken, section(bytes, SECTION_OFFSETS) + 8, 0);
+    errors += accepted(path, broken);
+
+    // a name that ends past the names section
+    broken = bytes;
+    poke<uint64_t>(broken, section(bytes, SECTION_NAME_STARTS) + 8, 1000);
+    errors += accepted(path, broken);
+
+    if (weighted) {
+        broken = bytes;
+        poke<int32_t>(broken, section(bytes, SECTION_WEIGHTS), 0);
+        errors += accepted(path, broken);
+    }
+
+    // the file itself, written back, still opens
+    errors += !accepted(path, bytes);
+
+    return errors;
+}
+
+int main() {
+    std::string path = "snapshot_test." + std::to_string(getpid());
+    int errors = run(path, false) + run(path, true);
+
+    unlink(path.c_str());
+
+    if (errors) {
+        printf("snapshot_test: %d mismatches\n", errors);
+        return 1;
+    }
+
+    printf("snapshot_test: OK\n");
+    return 0;
+}